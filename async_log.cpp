@@ -0,0 +1,161 @@
+#include "async_log.hpp"
+
+using namespace pang;
+
+namespace pang
+{
+  AsyncLog g_asyncLog;
+}
+
+namespace
+{
+  // how often the formatter thread wakes up to drain the ring
+  const u32 DRAIN_INTERVAL_MS = 5;
+}
+
+//----------------------------------------------------------------------------------
+const char* pang::LogLevelName(LogLevel level)
+{
+  switch (level)
+  {
+    case LogLevel::Debug: return "debug";
+    case LogLevel::Info: return "info";
+    case LogLevel::Warning: return "warning";
+    case LogLevel::Error: return "error";
+    default: return "unknown";
+  }
+}
+
+//----------------------------------------------------------------------------------
+AsyncLog::AsyncLog()
+    : _head(0)
+    , _tail(0)
+    , _numDropped(0)
+    , _frame(0)
+    , _startNs(0)
+    , _running(false)
+    , _overlay(false)
+    , _file(nullptr)
+    , _done(false)
+{
+}
+
+//----------------------------------------------------------------------------------
+AsyncLog::~AsyncLog()
+{
+  Stop();
+}
+
+//----------------------------------------------------------------------------------
+bool AsyncLog::Start(const string& filename, bool overlay)
+{
+  if (_running)
+    return false;
+
+  if (!filename.empty())
+  {
+    _file = fopen(filename.c_str(), "w");
+    if (!_file)
+      return false;
+  }
+
+  _ring.resize(RING_SIZE);
+  _head = 0;
+  _tail = 0;
+  _numDropped = 0;
+  _startNs = NowNs();
+  _overlay = overlay;
+  _done = false;
+  _thread = thread(&AsyncLog::FormatterThread, this);
+  _running = true;
+  return true;
+}
+
+//----------------------------------------------------------------------------------
+void AsyncLog::Stop()
+{
+  if (!_running)
+    return;
+
+  _running = false;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _done = true;
+  }
+  _cv.notify_one();
+  _thread.join();
+
+  if (_numDropped)
+    printf("async log dropped %u records\n", (u32)_numDropped);
+
+  if (_file)
+  {
+    fclose(_file);
+    _file = nullptr;
+  }
+}
+
+//----------------------------------------------------------------------------------
+void AsyncLog::FormatterThread()
+{
+  // the producer never signals, to keep writes cheap, so this polls the ring
+  bool done = false;
+  while (!done)
+  {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _cv.wait_for(lock, std::chrono::milliseconds(DRAIN_INTERVAL_MS));
+      done = _done;
+    }
+    Drain();
+  }
+}
+
+//----------------------------------------------------------------------------------
+void AsyncLog::Drain()
+{
+  u64 tail = _tail.load(std::memory_order_relaxed);
+  u64 head = _head.load(std::memory_order_acquire);
+  if (tail == head)
+    return;
+
+  vector<LogLine> lines;
+  char buf[512];
+  for (; tail != head; ++tail)
+  {
+    const Record& r = _ring[tail & (RING_SIZE - 1)];
+    r.format(buf, sizeof(buf), r.fmt, r.args);
+
+    if (_file)
+    {
+      fprintf(_file, "%10.4f %6u %-7s %s\n",
+          (r.timestamp - _startNs) / 1e9, r.frame, LogLevelName(r.level), buf);
+    }
+
+    if (_overlay)
+    {
+      LogLine line = { r.level, r.frame, buf };
+      lines.push_back(line);
+    }
+  }
+
+  // release the records back to the game thread
+  _tail.store(tail, std::memory_order_release);
+
+  if (_file)
+    fflush(_file);
+
+  if (!lines.empty())
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _lines.insert(_lines.end(), lines.begin(), lines.end());
+  }
+}
+
+//----------------------------------------------------------------------------------
+void AsyncLog::TakeLines(vector<LogLine>* lines)
+{
+  lines->clear();
+  std::lock_guard<std::mutex> lock(_mutex);
+  lines->swap(_lines);
+}
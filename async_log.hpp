@@ -0,0 +1,172 @@
+#pragma once
+#include "types.hpp"
+
+namespace pang
+{
+  enum class LogLevel
+  {
+    Debug,
+    Info,
+    Warning,
+    Error,
+  };
+
+  const char* LogLevelName(LogLevel level);
+
+  // a formatted line, handed to the on-screen overlay
+  struct LogLine
+  {
+    LogLevel level;
+    u32 frame;
+    string str;
+  };
+
+  union LogArg
+  {
+    s64 i;
+    double d;
+    const void* p;
+  };
+
+  template <u32... Is> struct LogIndices {};
+  template <u32 N, u32... Is> struct MakeLogIndices : MakeLogIndices<N - 1, N - 1, Is...> {};
+  template <u32... Is> struct MakeLogIndices<0, Is...> { typedef LogIndices<Is...> type; };
+
+  //----------------------------------------------------------------------------------
+  template <typename T>
+  LogArg ToLogArg(T v)
+  {
+    static_assert(std::is_arithmetic<T>::value || std::is_pointer<T>::value || std::is_enum<T>::value,
+        "log arguments must be numbers or pointers (and strings must outlive the log)");
+    static_assert(sizeof(T) <= sizeof(LogArg), "log arguments must fit in 8 bytes (no long double)");
+    LogArg arg;
+    memcpy(&arg, &v, sizeof(T));
+    return arg;
+  }
+
+  //----------------------------------------------------------------------------------
+  template <typename T>
+  T FromLogArg(const LogArg& arg)
+  {
+    T v;
+    memcpy(&v, &arg, sizeof(T));
+    return v;
+  }
+
+  //----------------------------------------------------------------------------------
+  inline void PackLogArgs(LogArg* out) {}
+
+  template <typename T, typename... Rest>
+  void PackLogArgs(LogArg* out, T v, Rest... rest)
+  {
+    *out = ToLogArg(v);
+    PackLogArgs(out + 1, rest...);
+  }
+
+  //----------------------------------------------------------------------------------
+  template <typename... Args, u32... Is>
+  int FormatLogArgs(char* buf, size_t size, const char* fmt, const LogArg* args, LogIndices<Is...>)
+  {
+    return snprintf(buf, size, fmt, FromLogArg<Args>(args[Is])...);
+  }
+
+  // records without arguments are copied as is, so they don't need % escaping
+  template <typename... Args>
+  int FormatLogArgs(char* buf, size_t size, const char* fmt, const LogArg* args, LogIndices<>)
+  {
+    return snprintf(buf, size, "%s", fmt);
+  }
+
+  template <typename... Args>
+  int FormatLogRecord(char* buf, size_t size, const char* fmt, const LogArg* args)
+  {
+    return FormatLogArgs<Args...>(buf, size, fmt, args, typename MakeLogIndices<sizeof...(Args)>::type());
+  }
+
+  // Asynchronous log. The game thread writes fixed size binary records (the format string,
+  // the arguments and a function that knows their types) into a lock-free single producer
+  // ring buffer, and a background thread formats them into the log file, and into lines
+  // for the overlay. Records are dropped if the ring is full.
+  // Note, the format string and any string arguments are stored as pointers, so they
+  // must be literals (or otherwise outlive the log)
+  class AsyncLog
+  {
+  public:
+    enum { RING_SIZE = 1 << 14, MAX_ARGS = 5 };
+
+    AsyncLog();
+    ~AsyncLog();
+
+    // the filename can be empty, to only feed the overlay. if overlay is false, no lines
+    // are kept for TakeLines
+    bool Start(const string& filename, bool overlay);
+    // formats any remaining records, and stops the formatter thread
+    void Stop();
+
+    template <typename... Args>
+    void Write(LogLevel level, const char* fmt, Args... args)
+    {
+      static_assert(sizeof...(Args) <= MAX_ARGS, "too many log arguments");
+      if (!_running)
+        return;
+
+      u64 head = _head.load(std::memory_order_relaxed);
+      if (head - _tail.load(std::memory_order_acquire) == RING_SIZE)
+      {
+        _numDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+
+      Record& r = _ring[head & (RING_SIZE - 1)];
+      r.format = &FormatLogRecord<Args...>;
+      r.fmt = fmt;
+      r.timestamp = NowNs();
+      r.frame = _frame;
+      r.level = level;
+      PackLogArgs(r.args, args...);
+      _head.store(head + 1, std::memory_order_release);
+    }
+
+    // records are tagged with the frame they were written in
+    void EndFrame() { ++_frame; }
+    u32 Frame() const { return _frame; }
+
+    // swaps out the lines formatted since the last call
+    void TakeLines(vector<LogLine>* lines);
+
+  private:
+    typedef int (*FormatFn)(char* buf, size_t size, const char* fmt, const LogArg* args);
+
+    struct Record
+    {
+      FormatFn format;
+      const char* fmt;
+      u64 timestamp;
+      u32 frame;
+      LogLevel level;
+      LogArg args[MAX_ARGS];
+    };
+
+    void FormatterThread();
+    void Drain();
+
+    vector<Record> _ring;
+    atomic<u64> _head;
+    atomic<u64> _tail;
+    atomic<u32> _numDropped;
+    u32 _frame;
+    u64 _startNs;
+    bool _running;
+    bool _overlay;
+
+    FILE* _file;
+    vector<LogLine> _lines;
+
+    thread _thread;
+    std::mutex _mutex;
+    condition_variable _cv;
+    bool _done;
+  };
+
+  extern AsyncLog g_asyncLog;
+}
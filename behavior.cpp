@@ -1,5 +1,7 @@
 #include "behavior.hpp"
 #include "entity.hpp"
+#include "profiler.hpp"
+#include "metrics.hpp"
 
 using namespace bristol;
 
@@ -20,95 +22,76 @@ namespace pang
     const float ANGLE_JITTER = 0.01f;
 
 
-    struct WanderState
-    {
-      WanderState() { memset(this, 0, sizeof(WanderState)); }
-      float _circleOffset;
-      float _circleRadius;
-      float _curAngle;
-      u32 _ticks;
-      int _dir;
-    };
-
-
     unordered_map<EntityId, WanderState> s_wanderState;
 
-    //----------------------------------------------------------------------------------
-    Vector2f CircleCenter(const Entity* e, const WanderState& s)
-    {
-      return e->_pos + s._circleOffset * Normalize(e->_vel);
-    }
-
   }
 
   //----------------------------------------------------------------------------------
-  void PursuitDebugRenderer::Render(RenderWindow* window)
+  const WanderState* FindWanderState(EntityId id)
   {
-    LineShape ll(_entity->_pos, _lookAhead);
-    ll.setFillColor(Color::Green);
-    window->draw(ll);
+    auto it = s_wanderState.find(id);
+    return it == s_wanderState.end() ? nullptr : &it->second;
   }
 
   //----------------------------------------------------------------------------------
-  void WanderDebugRenderer::Render(RenderWindow* window)
+  void RemoveWanderState(EntityId id)
   {
-    auto it = s_wanderState.find(_entity->_id);
-    if (it == s_wanderState.end())
-      return;
-
-    WanderState& s = it->second;
-    Vector2f center = CircleCenter(_entity, s);
-    LineShape ll(_entity->_pos, center);
-    ll.setFillColor(Color::Green);
-    window->draw(ll);
+    s_wanderState.erase(id);
+    g_metrics.Set(Metric::WanderStates, s_wanderState.size());
+  }
 
-    Vector2f pt = center + s._circleRadius * Vector2f(cosf(s._curAngle), sinf(s._curAngle));
-    LineShape ll2(_entity->_pos, pt);
-    ll2.setFillColor(Color::Yellow);
-    window->draw(ll2);
+  //----------------------------------------------------------------------------------
+  u32 NumWanderStates()
+  {
+    return (u32)s_wanderState.size();
+  }
 
+  //----------------------------------------------------------------------------------
+  Vector2f WanderCircleCenter(const EntityStore& entities, u32 e, const WanderState& s)
+  {
+    return entities._pos[e] + s._circleOffset * Normalize(entities._vel[e]);
   }
 
 
   //----------------------------------------------------------------------------------
-  Vector2f BehaviorSeek(const Entity* e, const Vector2f& dest)
+  Vector2f BehaviorSeek(const EntityStore& entities, u32 e, const Vector2f& dest)
   {
     // returns a force towards the dest
-    Vector2f desiredVel = MAX_SPEED * Normalize(dest - e->_pos);
-    return desiredVel - e->_vel;
+    Vector2f desiredVel = MAX_SPEED * Normalize(dest - entities._pos[e]);
+    return desiredVel - entities._vel[e];
   }
 
 //----------------------------------------------------------------------------------
-  Vector2f BehaviorArrive(const Entity* e, const Vector2f& dest)
+  Vector2f BehaviorArrive(const EntityStore& entities, u32 e, const Vector2f& dest)
   {
-    float dist = Length(dest - e->_pos);
+    PROFILE_COST(Arrive, entities._squadId[e]);
+    const Vector2f& pos = entities._pos[e];
+    float dist = Length(dest - pos);
     if (dist == 0)
       return Vector2f(0,0);
 
-    Vector2f desiredVel = MAX_SPEED * Normalize(dist * (dest - e->_pos));
-    return desiredVel - e->_vel;
+    Vector2f desiredVel = MAX_SPEED * Normalize(dist * (dest - pos));
+    return desiredVel - entities._vel[e];
   }
 
   //----------------------------------------------------------------------------------
-  Vector2f BehaviorPursuit(const Entity* e, const Entity* target)
+  Vector2f BehaviorPursuit(const EntityStore& entities, u32 e, u32 target)
   {
-    Vector2f toTarget(target->_pos - e->_pos);
+    PROFILE_COST(Pursuit, entities._squadId[e]);
+    Vector2f toTarget(entities._pos[target] - entities._pos[e]);
 
-    float s = Length(toTarget) / (Length(e->_vel) + Length(target->_vel));
-    Vector2f v = target->_pos + s * target->_vel;
-    if (e->_debug)
-    {
-      // meh, is there a better way to do this?
-      PursuitDebugRenderer* p = static_cast<PursuitDebugRenderer*>(e->_debug);
-      p->_lookAhead = v;
-    }
-    return BehaviorSeek(e, v);
+    float s = Length(toTarget) / (Length(entities._vel[e]) + Length(entities._vel[target]));
+    Vector2f v = entities._pos[target] + s * entities._vel[target];
+    entities._cold[e]._lookAhead = v;
+    return BehaviorSeek(entities, e, v);
   }
 
   //----------------------------------------------------------------------------------
-  Vector2f BehaviorWander(const Entity* e)
+  Vector2f BehaviorWander(const EntityStore& entities, u32 e)
   {
-    WanderState& s = s_wanderState[e->_id];
+    PROFILE_COST(Wander, entities._squadId[e]);
+    WanderState& s = s_wanderState[entities._id[e]];
+    g_metrics.Set(Metric::WanderStates, s_wanderState.size());
     if (s._circleOffset == 0)
     {
       // init
@@ -120,7 +103,7 @@ namespace pang
     }
 
     // project wander circle in front of entity
-    Vector2f center = CircleCenter(e, s);
+    Vector2f center = WanderCircleCenter(entities, e, s);
 
     // update wander angle
     s._curAngle += s._dir * randf(0.0f, ANGLE_JITTER);
@@ -135,12 +118,13 @@ namespace pang
     Vector2f pt = center + s._circleRadius * Vector2f(cosf(s._curAngle), sinf(s._curAngle));
 
     // force towards point
-    return Normalize(pt - e->_pos);
+    return Normalize(pt - entities._pos[e]);
   }
 
   //----------------------------------------------------------------------------------
-  Vector2f BehaviorAvoidWall(const Entity* e, const Level::Cell& cell)
+  Vector2f BehaviorAvoidWall(const EntityStore& entities, u32 e, const Level::Cell& cell)
   {
+    PROFILE_COST(AvoidWall, entities._squadId[e]);
     Vector2f res(0,0);
 
     float dist = g_behaviorSettings.wallDist;
@@ -157,7 +141,7 @@ namespace pang
   }
 
   //----------------------------------------------------------------------------------
-  Vector2f ApplyBehaviorProfile(const Entity* e, const BehaviorProfile& p)
+  Vector2f ApplyBehaviorProfile(const EntityStore& entities, u32 e, const BehaviorProfile& p)
   {
     Vector2f res(0,0);
 
@@ -200,6 +184,9 @@ namespace pang
   //----------------------------------------------------------------------------------
   void Coordinator::Update()
   {
+    g_metrics.Set(Metric::CoordinatorMessages, _messageQueue.size());
+    g_metrics.Add(Metric::CoordinatorMessagesTotal, _messageQueue.size());
+
     for (const AiMessage& msg : _messageQueue)
     {
       if (msg.type == AiMessageType::PlayerSpotted)
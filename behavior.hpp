@@ -4,9 +4,7 @@
 
 namespace pang
 {
-  struct Entity;
-
-  struct Entity;
+  class EntityStore;
 
   struct BehaviorSettings
   {
@@ -17,27 +15,6 @@ namespace pang
 
   extern BehaviorSettings g_behaviorSettings;
 
-  struct DebugRenderer
-  {
-    DebugRenderer(const Entity* entity) : _entity(entity) {}
-    virtual ~DebugRenderer() {};
-    const Entity* _entity;
-    virtual void Render(RenderWindow* window) = 0;
-  };
-
-  struct PursuitDebugRenderer : public DebugRenderer
-  {
-    PursuitDebugRenderer(const Entity* entity) : DebugRenderer(entity) {}
-    virtual void Render(RenderWindow* window);
-    Vector2f _lookAhead;
-  };
-
-  struct WanderDebugRenderer : public DebugRenderer
-  {
-    WanderDebugRenderer(const Entity* entity) : DebugRenderer(entity) {}
-    virtual void Render(RenderWindow* window);
-  };
-
   enum class Behavior
   {
     Seek,
@@ -50,14 +27,30 @@ namespace pang
 
   typedef array<float, (u32)Behavior::BehaviorCount> BehaviorProfile;
 
-  Vector2f ApplyBehaviorProfile(const Entity* e, const BehaviorProfile& p);
+  // the behaviors take the entity's slot in the store
+  Vector2f ApplyBehaviorProfile(const EntityStore& entities, u32 e, const BehaviorProfile& p);
+
+  Vector2f BehaviorSeek(const EntityStore& entities, u32 e, const Vector2f& dest);
+  Vector2f BehaviorArrive(const EntityStore& entities, u32 e, const Vector2f& dest);
+  Vector2f BehaviorPursuit(const EntityStore& entities, u32 e, u32 target);
 
-  Vector2f BehaviorSeek(const Entity* e, const Vector2f& dest);
-  Vector2f BehaviorArrive(const Entity* e, const Vector2f& dest);
-  Vector2f BehaviorPursuit(const Entity* e, const Entity* target);
+  Vector2f BehaviorWander(const EntityStore& entities, u32 e);
+  Vector2f BehaviorAvoidWall(const EntityStore& entities, u32 e, const Level::Cell& cell);
+
+  struct WanderState
+  {
+    WanderState() { memset(this, 0, sizeof(WanderState)); }
+    float _circleOffset;
+    float _circleRadius;
+    float _curAngle;
+    u32 _ticks;
+    int _dir;
+  };
 
-  Vector2f BehaviorWander(const Entity* e);
-  Vector2f BehaviorAvoidWall(const Entity* e, const Level::Cell& cell);
+  const WanderState* FindWanderState(EntityId id);
+  void RemoveWanderState(EntityId id);
+  u32 NumWanderStates();
+  Vector2f WanderCircleCenter(const EntityStore& entities, u32 e, const WanderState& s);
 
   enum class AiMessageType
   {
@@ -0,0 +1,99 @@
+#include "bench.hpp"
+
+using namespace pang;
+
+//----------------------------------------------------------------------------------
+void pang::PrintResultHeader()
+{
+  printf("%-28s %8s %14s %14s\n", "kernel", "size", "ns/op", "Mcells/s");
+}
+
+//----------------------------------------------------------------------------------
+void pang::PrintResult(const char* kernel, u32 size, double nsPerOp, double cellsPerOp)
+{
+  if (cellsPerOp > 0)
+    printf("%-28s %8u %14.1f %14.2f\n", kernel, size, nsPerOp, cellsPerOp / nsPerOp * 1e3);
+  else
+    printf("%-28s %8u %14.1f %14s\n", kernel, size, nsPerOp, "-");
+  fflush(stdout);
+}
+
+//----------------------------------------------------------------------------------
+pang::level::Level pang::MakeLevelConfig(u32 size)
+{
+  pang::level::Level config;
+  config.set_seed(BENCH_SEED);
+  config.set_width(size);
+  config.set_height(size);
+  config.set_min_room_width(10);
+  config.set_max_room_width(30);
+  config.set_min_room_height(10);
+  config.set_max_room_height(30);
+  return config;
+}
+
+//----------------------------------------------------------------------------------
+u64 pang::ResidentBytes()
+{
+#ifdef __linux__
+  FILE* f = fopen("/proc/self/statm", "rt");
+  if (!f)
+    return 0;
+
+  unsigned long size = 0, resident = 0;
+  int numRead = fscanf(f, "%lu %lu", &size, &resident);
+  fclose(f);
+  return numRead == 2 ? (u64)resident * sysconf(_SC_PAGESIZE) : 0;
+#else
+  return 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  // pang_bench level [size...]
+  if (argc >= 2 && strcmp(argv[1], "level") == 0)
+  {
+    vector<u32> sizes;
+    for (int i = 2; i < argc; ++i)
+      sizes.push_back((u32)atoi(argv[i]));
+
+    if (sizes.empty())
+      sizes = { 200, 1024, 4096 };
+
+    return RunLevelBench(sizes);
+  }
+
+  // pang_bench scaling [--record] [num entities...]
+  if (argc >= 2 && strcmp(argv[1], "scaling") == 0)
+  {
+    bool record = false;
+    vector<u32> numEntities;
+    for (int i = 2; i < argc; ++i)
+    {
+      if (strcmp(argv[i], "--record") == 0)
+        record = true;
+      else
+        numEntities.push_back((u32)atoi(argv[i]));
+    }
+
+    if (numEntities.empty())
+      numEntities = { 400, 1000, 4000, 10000, 40000, 100000 };
+
+    return RunScalingBench(numEntities, record);
+  }
+
+  // pang_bench soak [minutes] [num entities]
+  if (argc >= 2 && strcmp(argv[1], "soak") == 0)
+  {
+    double minutes = argc >= 3 ? atof(argv[2]) : 1;
+    u32 numEntities = argc >= 4 ? (u32)atoi(argv[3]) : 1000;
+    return RunSoakBench(numEntities, minutes);
+  }
+
+  printf("usage: %s level [size...]\n", argv[0]);
+  printf("       %s scaling [--record] [num entities...]\n", argv[0]);
+  printf("       %s soak [minutes] [num entities]\n", argv[0]);
+  return 1;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "types.hpp"
+#include "protocol/level.pb.h"
+
+namespace pang
+{
+  const u32 BENCH_SEED = 1337;
+
+  // runs fn repeatedly for at least minTime_s (and at least once), and returns the
+  // average time per call in ns
+  template <typename Fn>
+  double TimeCall(const Fn& fn, double minTime_s = 0.25)
+  {
+    u64 start = NowNs();
+    u64 elapsed = 0;
+    u32 iterations = 0;
+    do
+    {
+      fn();
+      ++iterations;
+      elapsed = NowNs() - start;
+    } while (elapsed < minTime_s * 1e9);
+
+    return (double)elapsed / iterations;
+  }
+
+  void PrintResultHeader();
+  // prints the time per op, and the throughput if cellsPerOp is non-zero
+  void PrintResult(const char* kernel, u32 size, double nsPerOp, double cellsPerOp);
+
+  // the same room sizes as config/level1.pb, on a size x size level
+  pang::level::Level MakeLevelConfig(u32 size);
+
+  int RunLevelBench(const vector<u32>& sizes);
+  // record runs the flight recorder, timed on its own and left out of the total
+  int RunScalingBench(const vector<u32>& numEntities, bool record);
+  // spawns and destroys entities for the given time, and fails if the memory use grows
+  int RunSoakBench(u32 numEntities, double minutes);
+
+  // the process' resident set size in bytes. 0 if unknown, which it is outside linux
+  u64 ResidentBytes();
+}
@@ -0,0 +1,164 @@
+#include "bench.hpp"
+#include "level.hpp"
+#include "generator.hpp"
+
+using namespace pang;
+
+namespace
+{
+  const u32 NUM_LINES = 1024;
+  // random lines tried when looking for blocked ones, so a level without walls finishes
+  const u32 MAX_BLOCKED_TRIES = 256 * NUM_LINES;
+
+  struct Line
+  {
+    u32 x0, y0, x1, y1;
+  };
+
+  //----------------------------------------------------------------------------------
+  u32 RandRange(u32 lo, u32 hi)
+  {
+    // [lo, hi)
+    return lo + rand() % (hi - lo);
+  }
+
+  //----------------------------------------------------------------------------------
+  double NumCells(const Line& l)
+  {
+    // number of cells walked by an unblocked bresenham line
+    u32 dx = l.x1 > l.x0 ? l.x1 - l.x0 : l.x0 - l.x1;
+    u32 dy = l.y1 > l.y0 ? l.y1 - l.y0 : l.y0 - l.y1;
+    return max(dx, dy) + 1;
+  }
+}
+
+namespace pang
+{
+  struct LevelBench
+  {
+    static bool Run(u32 size);
+    static void BenchVisibility(Level& level, u32 size);
+  };
+}
+
+//----------------------------------------------------------------------------------
+void LevelBench::BenchVisibility(Level& level, u32 size)
+{
+  vector<Line> shortLines, longLines, blockedLines;
+
+  // blocked lines are taken from the generated level
+  srand(BENCH_SEED);
+  for (u32 i = 0; i < MAX_BLOCKED_TRIES && blockedLines.size() < NUM_LINES; ++i)
+  {
+    Line l = { RandRange(0, size), RandRange(0, size), RandRange(0, size), RandRange(0, size) };
+    if (level._data[l.y0 * size + l.x0].terrain == 0 && !level.IsVisible(l.x0, l.y0, l.x1, l.y1))
+      blockedLines.push_back(l);
+  }
+
+  // short and long lines are walked on an open level, so they run to completion
+  for (Level::Cell& cell : level._data)
+    cell.terrain = 0;
+
+  while (shortLines.size() < NUM_LINES)
+  {
+    u32 x0 = RandRange(0, size), y0 = RandRange(0, size);
+    Line l = { x0, y0, min(size - 1, x0 + RandRange(0, 16)), min(size - 1, y0 + RandRange(0, 16)) };
+    if (rand() % 2)
+      std::swap(l.x0, l.x1);
+    shortLines.push_back(l);
+  }
+
+  while (longLines.size() < NUM_LINES)
+  {
+    Line l = { RandRange(0, size / 4), RandRange(0, size), RandRange(3 * size / 4, size), RandRange(0, size) };
+    if (rand() % 2)
+      std::swap(l.y0, l.y1);
+    longLines.push_back(l);
+  }
+
+  const auto& fnBench = [&](const char* name, const vector<Line>& lines, bool blocked)
+  {
+    u32 numVisible = 0;
+    double cells = 0;
+    for (const Line& l : lines)
+      cells += NumCells(l);
+
+    double ns = TimeCall([&]() {
+      for (const Line& l : lines)
+        numVisible += level.IsVisible(l.x0, l.y0, l.x1, l.y1);
+    });
+
+    // note, a blocked line stops at the first wall, so there is no fixed cell count
+    PrintResult(name, size, ns / lines.size(), blocked ? 0 : cells / lines.size());
+    return numVisible;
+  };
+
+  fnBench("IsVisible (short)", shortLines, false);
+  fnBench("IsVisible (long)", longLines, false);
+  level.CalcTerrain();
+  if (blockedLines.empty())
+    printf("%-28s %8u %14s (no blocked lines found)\n", "IsVisible (blocked)", size, "-");
+  else
+    fnBench("IsVisible (blocked)", blockedLines, true);
+}
+
+//----------------------------------------------------------------------------------
+bool LevelBench::Run(u32 size)
+{
+  pang::level::Level config = MakeLevelConfig(size);
+  double numCells = (double)size * size;
+
+  double ns = TimeCall([&]() {
+    srand(BENCH_SEED);
+    Generator gen;
+    gen.Run(config);
+  });
+  PrintResult("Generator::Run", size, ns, numCells);
+
+  Level level;
+  srand(BENCH_SEED);
+  if (!level.Init(size, size, config))
+  {
+    printf("unable to create a level of size %u\n", size);
+    return false;
+  }
+
+  ns = TimeCall([&]() {
+    srand(BENCH_SEED);
+    level.CalcAdjacency();
+  });
+  PrintResult("Level::CalcAdjacency", size, ns, numCells);
+
+  ns = TimeCall([&]() { level.CalcWallDistance(); });
+  PrintResult("Level::CalcWallDistance", size, ns, numCells);
+
+  ns = TimeCall([&]() { level.Diffuse(); });
+  PrintResult("Level::Diffuse", size, ns, numCells);
+
+  vector<u32> pixels;
+  ns = TimeCall([&]() { level.GetPixels(&pixels); });
+  PrintResult("Level::GetPixels", size, ns, numCells);
+
+  BenchVisibility(level, size);
+  return true;
+}
+
+//----------------------------------------------------------------------------------
+int pang::RunLevelBench(const vector<u32>& sizes)
+{
+  printf("level kernels, seed %u\n", BENCH_SEED);
+  PrintResultHeader();
+
+  for (u32 size : sizes)
+  {
+    if (size < 64)
+    {
+      printf("size %u is too small\n", size);
+      return 1;
+    }
+    if (!LevelBench::Run(size))
+      return 1;
+  }
+
+  return 0;
+}
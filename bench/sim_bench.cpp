@@ -0,0 +1,146 @@
+#include "bench.hpp"
+#include "simulation.hpp"
+#include "behavior.hpp"
+#include "flight_recorder.hpp"
+
+using namespace pang;
+using namespace bristol;
+
+namespace
+{
+  // squads are the same size as in config/game_large.pb
+  const u32 MOBS_PER_SQUAD = 4;
+
+  // the level is scaled to keep roughly the entity density of config/game_large.pb
+  const u32 CELLS_PER_ENTITY = 100;
+  const u32 MIN_LEVEL_SIZE = 200;
+
+  // one bullet in flight per ENTITIES_PER_BULLET entities
+  const u32 ENTITIES_PER_BULLET = 100;
+
+  const double MIN_TIME_S = 1.0;
+
+  const u32 FLIGHT_BUFFER_BYTES = 64 << 20;
+}
+
+namespace pang
+{
+  struct SimBench
+  {
+    static bool Run(u32 numEntities, bool record);
+  };
+}
+
+//----------------------------------------------------------------------------------
+bool SimBench::Run(u32 numEntities, bool record)
+{
+  // the local player is the extra entity
+  u32 numSquads = max(1u, (numEntities - 1) / MOBS_PER_SQUAD);
+  u32 size = max(MIN_LEVEL_SIZE, (u32)sqrt((double)numEntities * CELLS_PER_ENTITY));
+
+  config::Game gameConfig;
+  gameConfig.set_width(size);
+  gameConfig.set_height(size);
+  gameConfig.set_num_squads(numSquads);
+  gameConfig.set_mobs_per_squad(MOBS_PER_SQUAD);
+
+  srand(BENCH_SEED);
+  Simulation sim;
+  if (!sim.Init(gameConfig, MakeLevelConfig(size)))
+  {
+    printf("unable to create a simulation with %u entities\n", numEntities);
+    return false;
+  }
+
+  for (u32 e = 0; e < sim._entities.Size(); e += ENTITIES_PER_BULLET)
+  {
+    float angle = randf(0.0f, 2 * PI);
+    Bullet b = { sim._entities._id[e], Vector2f(sinf(angle), -cosf(angle)), sim._entities._pos[e] };
+    sim._bullets.push_back(b);
+  }
+
+  u32 numStartEntities = sim._entities.Size();
+  u32 numStartBullets = (u32)sim._bullets.size();
+
+  // run whole ticks, in the same order as Simulation::Update with every system due on
+  // every tick, but with each phase timed on its own
+  u64 tick_us = sim.TickDuration();
+  u64 recordNs = 0, physicsNs = 0, visibilityNs = 0, bulletsNs = 0, coordinatorNs = 0, enemiesNs = 0, sortNs = 0;
+  u32 numTicks = 0;
+  // the spatial sort runs at its configured rate, the first time before the first tick
+  u32 sortInterval = sim._gameConfig.spatial_sort_hz() > 0
+    ? max(1, sim._gameConfig.physics_hz() / sim._gameConfig.spatial_sort_hz()) : 0;
+  if (record)
+    g_flightRecorder.Start(FLIGHT_BUFFER_BYTES, tick_us);
+  u64 start = NowNs();
+  do
+  {
+    if (sortInterval && numTicks % sortInterval == 0)
+    {
+      u64 ts = NowNs();
+      sim.SortEntities();
+      sortNs += NowNs() - ts;
+    }
+
+    u64 tr = NowNs();
+    if (record)
+      g_flightRecorder.Record(numTicks, sim._entities, sim._visibility);
+    u64 t0 = NowNs();
+    sim.PhysicsUpdate(tick_us / 1000.0f);
+    u64 t1 = NowNs();
+    sim.UpdateVisibility();
+    u64 t2 = NowNs();
+    sim.UpdateBullets(tick_us / 1e6f);
+    sim._lifecycle.Flush();
+    u64 t3 = NowNs();
+    COORDINATOR.Update();
+    // keep the enemies running if a bullet hits the player
+    sim._playerDead = false;
+    u64 t4 = NowNs();
+    sim.UpdateEnemies();
+    u64 t5 = NowNs();
+
+    recordNs += t0 - tr;
+    physicsNs += t1 - t0;
+    visibilityNs += t2 - t1;
+    bulletsNs += t3 - t2;
+    coordinatorNs += t4 - t3;
+    enemiesNs += t5 - t4;
+    ++numTicks;
+  } while (NowNs() - start < MIN_TIME_S * 1e9);
+  if (record)
+    g_flightRecorder.Stop();
+
+  // the total is the tick itself, so it's comparable with and without recording
+  double scale = 1e-3 / numTicks;
+  printf("%10u %8u %8u %8u %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f\n",
+      numStartEntities, size, numStartBullets, numTicks,
+      recordNs * scale, physicsNs * scale, visibilityNs * scale, bulletsNs * scale, coordinatorNs * scale,
+      enemiesNs * scale, sortNs * scale,
+      (physicsNs + visibilityNs + bulletsNs + coordinatorNs + enemiesNs + sortNs) * scale);
+  fflush(stdout);
+  return true;
+}
+
+//----------------------------------------------------------------------------------
+int pang::RunScalingBench(const vector<u32>& numEntities, bool record)
+{
+  printf("simulation tick scaling, seed %u, times in us/tick\n", BENCH_SEED);
+  printf("%10s %8s %8s %8s %12s %12s %12s %12s %12s %12s %12s %12s\n",
+      "entities", "size", "bullets", "ticks", "record", "physics", "visibility", "bullets", "coordinator",
+      "enemies", "sort", "total");
+
+  for (u32 n : numEntities)
+  {
+    if (n < 2)
+    {
+      printf("%u entities is too few\n", n);
+      return 1;
+    }
+
+    if (!SimBench::Run(n, record))
+      return 1;
+  }
+
+  return 0;
+}
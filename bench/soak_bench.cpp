@@ -0,0 +1,199 @@
+#include "bench.hpp"
+#include "simulation.hpp"
+#include "behavior.hpp"
+
+using namespace pang;
+using namespace bristol;
+
+namespace
+{
+  // the same sizes and density as the scaling benchmark
+  const u32 MOBS_PER_SQUAD = 4;
+  const u32 CELLS_PER_ENTITY = 100;
+  const u32 MIN_LEVEL_SIZE = 200;
+  const u32 ENTITIES_PER_BULLET = 100;
+
+  // every simulated second, one enemy in CHURN_DIVISOR is destroyed and the population is
+  // topped up again
+  const u32 CHURN_DIVISOR = 10;
+
+  const double REPORT_INTERVAL_S = 10;
+
+  // the resident size can drift this much after the first report
+  const u64 RSS_SLACK_BYTES = 4 << 20;
+}
+
+namespace pang
+{
+  struct SoakBench
+  {
+    static bool Run(u32 numEntities, double minutes);
+    static bool Check(Simulation& sim, u32 peakEntities, u64 baseRss, double elapsed_s);
+  };
+}
+
+//----------------------------------------------------------------------------------
+bool SoakBench::Check(Simulation& sim, u32 peakEntities, u64 baseRss, double elapsed_s)
+{
+  const EntityStore& entities = sim._entities;
+
+  // the handle table only grows when no more than MIN_FREE_INDICES entries are free
+  u32 maxHandles = peakEntities + EntityStore::MIN_FREE_INDICES;
+
+  u32 numStamps = 0, numStaleStamps = 0;
+  u32 w, h;
+  sim._level.GetSize(&w, &h);
+  for (u32 y = 0; y < h; ++y)
+  {
+    for (u32 x = 0; x < w; ++x)
+    {
+      Level::Cell* cell;
+      if (sim._level.GetCell(Tile(x, y), &cell) && cell->entityId != NO_ENTITY)
+      {
+        ++numStamps;
+        numStaleStamps += entities.IsAlive(cell->entityId) ? 0 : 1;
+      }
+    }
+  }
+
+  u32 numSquads = (u32)(sim._squadSizes.size() - sim._freeSquads.size());
+  u64 rss = ResidentBytes();
+
+  printf("%8.0f %10u %12llu %10u %8u %8u %8u %12.1f\n",
+      elapsed_s, entities.Size(), (unsigned long long)sim._lifecycle.NumDestroyed(), entities.NumHandles(),
+      NumWanderStates(), numStamps, numSquads, rss / 1048576.0);
+  fflush(stdout);
+
+  bool res = true;
+  if (entities.NumHandles() > maxHandles)
+  {
+    printf("the handle table has %u entries, more than %u\n", entities.NumHandles(), maxHandles);
+    res = false;
+  }
+
+  if (NumWanderStates() > entities.Size())
+  {
+    printf("%u wander states for %u entities\n", NumWanderStates(), entities.Size());
+    res = false;
+  }
+
+  if (numStaleStamps)
+  {
+    printf("%u cells hold a destroyed entity\n", numStaleStamps);
+    res = false;
+  }
+
+  if (numSquads > entities.Size())
+  {
+    printf("%u squads for %u entities\n", numSquads, entities.Size());
+    res = false;
+  }
+
+  if (baseRss && rss > baseRss + RSS_SLACK_BYTES)
+  {
+    printf("the resident size grew from %.1f MB to %.1f MB\n", baseRss / 1048576.0, rss / 1048576.0);
+    res = false;
+  }
+
+  return res;
+}
+
+//----------------------------------------------------------------------------------
+bool SoakBench::Run(u32 numEntities, double minutes)
+{
+  u32 numSquads = max(1u, (numEntities - 1) / MOBS_PER_SQUAD);
+  u32 size = max(MIN_LEVEL_SIZE, (u32)sqrt((double)numEntities * CELLS_PER_ENTITY));
+
+  config::Game gameConfig;
+  gameConfig.set_width(size);
+  gameConfig.set_height(size);
+  gameConfig.set_num_squads(numSquads);
+  gameConfig.set_mobs_per_squad(MOBS_PER_SQUAD);
+
+  srand(BENCH_SEED);
+  Simulation sim;
+  if (!sim.Init(gameConfig, MakeLevelConfig(size)))
+  {
+    printf("unable to create a simulation with %u entities\n", numEntities);
+    return false;
+  }
+
+  printf("soak, seed %u, %u entities, %.1f minutes\n", BENCH_SEED, sim._entities.Size(), minutes);
+  printf("%8s %10s %12s %10s %8s %8s %8s %12s\n",
+      "time (s)", "entities", "destroyed", "handles", "wander", "stamps", "squads", "rss (MB)");
+
+  u32 targetEntities = sim._entities.Size();
+  u32 peakEntities = targetEntities;
+  u64 tick_us = sim.TickDuration();
+  u32 ticksPerSecond = sim._gameConfig.physics_hz();
+  // the first report is the baseline, once the side tables have grown to their working size
+  u64 baseRss = 0;
+  bool res = true;
+
+  u64 start = NowNs();
+  double nextReport = REPORT_INTERVAL_S;
+  double elapsed = 0;
+  while (elapsed < minutes * 60 && res)
+  {
+    EntityStore& entities = sim._entities;
+    u32 localPlayer = EntityStore::INVALID_SLOT;
+    sim.FindLocalPlayer(&localPlayer);
+
+    // kill some enemies directly, and fire some bullets to kill others
+    for (u32 i = 0, n = entities.Size() / CHURN_DIVISOR; i < n; ++i)
+    {
+      u32 e = rand() % entities.Size();
+      if (e != localPlayer)
+        sim._lifecycle.Destroy(entities._id[e]);
+    }
+
+    for (u32 e = 0; e < entities.Size(); e += ENTITIES_PER_BULLET)
+    {
+      float angle = randf(0.0f, 2 * PI);
+      Bullet b = { entities._id[e], Vector2f(sinf(angle), -cosf(angle)), entities._pos[e] };
+      sim._bullets.push_back(b);
+    }
+
+    for (u32 i = 0; i < ticksPerSecond; ++i)
+    {
+      sim.Update(tick_us);
+      // keep the enemies running if a bullet hits the player
+      sim._playerDead = false;
+    }
+
+    while (entities.Size() < targetEntities)
+    {
+      if (!sim.SpawnSquad())
+      {
+        printf("unable to spawn a squad\n");
+        res = false;
+        break;
+      }
+    }
+    peakEntities = max(peakEntities, entities.Size());
+
+    elapsed = (NowNs() - start) / 1e9;
+    if (elapsed >= nextReport || elapsed >= minutes * 60)
+    {
+      res = Check(sim, peakEntities, baseRss, elapsed) && res;
+      if (!baseRss)
+        baseRss = ResidentBytes();
+      nextReport += REPORT_INTERVAL_S;
+    }
+  }
+
+  printf(res ? "soak passed\n" : "soak FAILED\n");
+  return res;
+}
+
+//----------------------------------------------------------------------------------
+int pang::RunSoakBench(u32 numEntities, double minutes)
+{
+  if (numEntities < 2)
+  {
+    printf("%u entities is too few\n", numEntities);
+    return 1;
+  }
+
+  return SoakBench::Run(numEntities, minutes) ? 0 : 1;
+}
@@ -0,0 +1,262 @@
+#include "checksum.hpp"
+
+using namespace pang;
+
+namespace pang
+{
+  ChecksumStream g_checksums;
+}
+
+namespace
+{
+  const char CHECKSUM_MAGIC[8] = { 'P', 'A', 'N', 'G', 'C', 'H', 'K', '2' };
+
+  // the stream is written from the physics loop, so it's buffered generously
+  const u32 WRITE_BUFFER_SIZE = 1 << 20;
+
+  //----------------------------------------------------------------------------------
+  bool ReadTick(FILE* f, TickChecksum* tick, vector<EntityChecksum>* entities)
+  {
+    if (fread(tick, sizeof(*tick), 1, f) != 1)
+      return false;
+
+    entities->resize(tick->hasEntities ? tick->numEntities : 0);
+    if (!entities->empty() && fread(entities->data(), sizeof(EntityChecksum), tick->numEntities, f) != tick->numEntities)
+      return false;
+
+    sort(entities->begin(), entities->end(),
+        [](const EntityChecksum& a, const EntityChecksum& b) { return a.id < b.id; });
+    return true;
+  }
+
+  //----------------------------------------------------------------------------------
+  FILE* OpenStream(const string& filename)
+  {
+    FILE* f = fopen(filename.c_str(), "rb");
+    if (!f)
+    {
+      printf("unable to open %s\n", filename.c_str());
+      return nullptr;
+    }
+
+    char magic[sizeof(CHECKSUM_MAGIC)];
+    if (fread(magic, sizeof(magic), 1, f) != 1 || memcmp(magic, CHECKSUM_MAGIC, sizeof(magic)) != 0)
+    {
+      printf("%s isn't a checksum stream\n", filename.c_str());
+      fclose(f);
+      return nullptr;
+    }
+
+    return f;
+  }
+
+  //----------------------------------------------------------------------------------
+  bool FindEntityDivergence(const vector<EntityChecksum>& a, const vector<EntityChecksum>& b, char* buf, size_t size)
+  {
+    // both are sorted by id
+    auto ia = a.begin();
+    auto ib = b.begin();
+    while (ia != a.end() || ib != b.end())
+    {
+      if (ib == b.end() || (ia != a.end() && ia->id < ib->id))
+      {
+        snprintf(buf, size, "entity %u only exists in a", ia->id);
+        return true;
+      }
+
+      if (ia == a.end() || ib->id < ia->id)
+      {
+        snprintf(buf, size, "entity %u only exists in b", ib->id);
+        return true;
+      }
+
+      if (ia->hash != ib->hash)
+      {
+        snprintf(buf, size, "entity %u differs: %08x vs %08x", ia->id, ia->hash, ib->hash);
+        return true;
+      }
+
+      ++ia;
+      ++ib;
+    }
+
+    return false;
+  }
+
+  //----------------------------------------------------------------------------------
+  void PrintEntityDivergence(FILE* fa, FILE* fb, TickChecksum* a, TickChecksum* b,
+      vector<EntityChecksum>* entitiesA, vector<EntityChecksum>* entitiesB)
+  {
+    // the entity hashes are only in some ticks, so read on to the first tick from the
+    // divergence on where both streams have them and they differ. an entity that
+    // differs after the divergence may have been thrown off by one that diverged first
+    u32 divergedTick = a->tick;
+    char buf[128];
+    while (!a->hasEntities || !b->hasEntities || !FindEntityDivergence(*entitiesA, *entitiesB, buf, sizeof(buf)))
+    {
+      if (!ReadTick(fa, a, entitiesA) || !ReadTick(fb, b, entitiesB) || a->tick != b->tick)
+      {
+        printf("  entities differ. write entity hashes with --checksum-entities 1 to find which\n");
+        return;
+      }
+    }
+
+    if (a->tick == divergedTick)
+      printf("  %s\n", buf);
+    else
+      printf("  entities differ, and the entity hashes first differ at tick %u: %s\n", a->tick, buf);
+  }
+}
+
+//----------------------------------------------------------------------------------
+ChecksumStream::ChecksumStream()
+    : _file(nullptr)
+    , _numTicks(0)
+    , _entityInterval(0)
+{
+}
+
+//----------------------------------------------------------------------------------
+ChecksumStream::~ChecksumStream()
+{
+  Close();
+}
+
+//----------------------------------------------------------------------------------
+bool ChecksumStream::Open(const string& filename, u32 entityInterval)
+{
+  if (_file)
+    return false;
+
+  _file = fopen(filename.c_str(), "wb");
+  if (!_file)
+    return false;
+
+  setvbuf(_file, nullptr, _IOFBF, WRITE_BUFFER_SIZE);
+  fwrite(CHECKSUM_MAGIC, sizeof(CHECKSUM_MAGIC), 1, _file);
+  _numTicks = 0;
+  _entityInterval = entityInterval;
+  return true;
+}
+
+//----------------------------------------------------------------------------------
+void ChecksumStream::Close()
+{
+  if (!_file)
+    return;
+
+  fclose(_file);
+  _file = nullptr;
+}
+
+//----------------------------------------------------------------------------------
+void ChecksumStream::Write(u32 tick, const EntityStore& entities, const vector<Bullet>& bullets, const Level& level)
+{
+  if (!_file)
+    return;
+
+  TickChecksum res;
+  memset(&res, 0, sizeof(res));
+  res.tick = tick;
+  res.numEntities = entities.Size();
+  res.numBullets = (u32)bullets.size();
+  res.hasEntities = _entityInterval && tick % _entityInterval == 0;
+
+  // the entity hashes are summed, so the order of the slots doesn't matter
+  _entities.resize(res.hasEntities ? entities.Size() : 0);
+  for (u32 i = 0; i < entities.Size(); ++i)
+  {
+    u64 h = HashMix(entities._id[i]);
+    h = HashFloats(h, entities._pos[i].x, entities._pos[i].y);
+    h = HashFloats(h, entities._vel[i].x, entities._vel[i].y);
+    h = HashFloats(h, entities._rot[i], 0);
+    res.entities += h;
+    if (res.hasEntities)
+    {
+      _entities[i].id = entities._id[i];
+      _entities[i].hash = (u32)(h ^ (h >> 32));
+    }
+  }
+
+  // while the bullet order is part of the state
+  for (const Bullet& b : bullets)
+  {
+    res.bullets = HashCombine(res.bullets, b.entityId);
+    res.bullets = HashFloats(res.bullets, b.pos.x, b.pos.y);
+    res.bullets = HashFloats(res.bullets, b.dir.x, b.dir.y);
+  }
+
+  res.heat = level.HeatHash();
+  res.world = HashCombine(HashCombine(HashCombine(res.entities, res.bullets), res.heat),
+      ((u64)res.numEntities << 32) | res.numBullets);
+
+  fwrite(&res, sizeof(res), 1, _file);
+  fwrite(_entities.data(), sizeof(EntityChecksum), _entities.size(), _file);
+  ++_numTicks;
+}
+
+//----------------------------------------------------------------------------------
+bool ChecksumStream::Compare(const string& filenameA, const string& filenameB)
+{
+  FILE* fa = OpenStream(filenameA);
+  FILE* fb = OpenStream(filenameB);
+  if (!fa || !fb)
+  {
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return false;
+  }
+
+  TickChecksum a, b;
+  vector<EntityChecksum> entitiesA, entitiesB;
+  u32 numTicks = 0;
+  bool res = true;
+  while (true)
+  {
+    bool hasA = ReadTick(fa, &a, &entitiesA);
+    bool hasB = ReadTick(fb, &b, &entitiesB);
+    if (!hasA || !hasB)
+    {
+      if (hasA != hasB)
+      {
+        printf("%s ends after %u ticks, while the other stream continues\n",
+            hasA ? filenameB.c_str() : filenameA.c_str(), numTicks);
+        res = false;
+      }
+      break;
+    }
+
+    if (a.tick != b.tick)
+    {
+      printf("the streams are out of step after %u ticks: tick %u vs %u\n", numTicks, a.tick, b.tick);
+      res = false;
+      break;
+    }
+
+    if (a.world != b.world)
+    {
+      printf("first divergence at tick %u\n", a.tick);
+      if (a.numEntities != b.numEntities)
+        printf("  entity count: %u vs %u\n", a.numEntities, b.numEntities);
+      if (a.numBullets != b.numBullets)
+        printf("  bullet count: %u vs %u\n", a.numBullets, b.numBullets);
+      else if (a.bullets != b.bullets)
+        printf("  bullets differ\n");
+      if (a.heat != b.heat)
+        printf("  level heat differs\n");
+      if (a.entities != b.entities)
+        PrintEntityDivergence(fa, fb, &a, &b, &entitiesA, &entitiesB);
+      res = false;
+      break;
+    }
+
+    ++numTicks;
+  }
+
+  fclose(fa);
+  fclose(fb);
+
+  if (res)
+    printf("%u ticks match\n", numTicks);
+  return res;
+}
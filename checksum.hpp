@@ -0,0 +1,60 @@
+#pragma once
+#include "types.hpp"
+#include "simulation.hpp"
+
+namespace pang
+{
+  struct EntityChecksum
+  {
+    EntityId id;
+    u32 hash;
+  };
+
+  struct TickChecksum
+  {
+    u32 tick;
+    u32 numEntities;
+    u32 numBullets;
+    // an EntityChecksum per entity follows, if set
+    u32 hasEntities;
+    u64 world;
+    u64 entities;
+    u64 bullets;
+    u64 heat;
+  };
+
+  // Stream of world state hashes, written after every physics tick, to check that an
+  // optimization leaves the simulation bit for bit unchanged, for instance by comparing
+  // the streams of two builds replaying the same recording.
+  // Each tick holds hashes of the entities' positions, velocities and rotations, of the
+  // bullet list and of the level heat. The entity hashes are combined independent of the
+  // entities' slots in the store.
+  // Every entityInterval'th tick is also followed by a hash per entity, so a mismatch can
+  // be narrowed down to an entity that diverged. They're off by default, as they make
+  // the stream 8 bytes per entity per tick
+  class ChecksumStream
+  {
+  public:
+    ChecksumStream();
+    ~ChecksumStream();
+
+    // 0 entityInterval writes no entity hashes
+    bool Open(const string& filename, u32 entityInterval);
+    void Close();
+    bool IsOpen() const { return _file != nullptr; }
+
+    void Write(u32 tick, const EntityStore& entities, const vector<Bullet>& bullets, const Level& level);
+
+    // prints where two streams first diverge, and the first entity that differs in the
+    // first entity hashes from then on. true if they match
+    static bool Compare(const string& filenameA, const string& filenameB);
+
+  private:
+    FILE* _file;
+    u32 _numTicks;
+    u32 _entityInterval;
+    vector<EntityChecksum> _entities;
+  };
+
+  extern ChecksumStream g_checksums;
+}
@@ -0,0 +1,16 @@
+#include "clock.hpp"
+
+using namespace pang;
+
+//----------------------------------------------------------------------------------
+SteadyClock::SteadyClock()
+    : _start(std::chrono::steady_clock::now())
+{
+}
+
+//----------------------------------------------------------------------------------
+u64 SteadyClock::NowUs() const
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - _start).count();
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "types.hpp"
+
+namespace pang
+{
+  // The time source of the game loop, used to measure how much time to simulate and for
+  // ui timers. Gameplay timers count physics ticks instead, so they don't depend on it
+  class Clock
+  {
+  public:
+    virtual ~Clock() {}
+    // microseconds since an arbitrary fixed point. never goes backwards
+    virtual u64 NowUs() const = 0;
+  };
+
+  // Wall time, from std::chrono::steady_clock
+  class SteadyClock : public Clock
+  {
+  public:
+    SteadyClock();
+    virtual u64 NowUs() const;
+
+  private:
+    std::chrono::steady_clock::time_point _start;
+  };
+
+  // Only moves when advanced, so headless and replay runs can simulate as fast as the
+  // cpu allows, independent of wall time
+  class ManualClock : public Clock
+  {
+  public:
+    ManualClock() : _now(0) {}
+    virtual u64 NowUs() const { return _now; }
+    void Advance(u64 delta_us) { _now += delta_us; }
+
+  private:
+    u64 _now;
+  };
+}
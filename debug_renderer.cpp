@@ -0,0 +1,41 @@
+#include "debug_renderer.hpp"
+#include "behavior.hpp"
+#include "entity.hpp"
+
+using namespace bristol;
+
+namespace pang
+{
+  //----------------------------------------------------------------------------------
+  void PursuitDebugRenderer::Render(RenderWindow* window)
+  {
+    u32 e;
+    if (!_entities->Find(_id, &e))
+      return;
+
+    LineShape ll(_entities->_pos[e], _entities->_cold[e]._lookAhead);
+    ll.setFillColor(Color::Green);
+    window->draw(ll);
+  }
+
+  //----------------------------------------------------------------------------------
+  void WanderDebugRenderer::Render(RenderWindow* window)
+  {
+    u32 e;
+    const WanderState* s = FindWanderState(_id);
+    if (!s || !_entities->Find(_id, &e))
+      return;
+
+    const Vector2f& pos = _entities->_pos[e];
+    Vector2f center = WanderCircleCenter(*_entities, e, *s);
+    LineShape ll(pos, center);
+    ll.setFillColor(Color::Green);
+    window->draw(ll);
+
+    Vector2f pt = center + s->_circleRadius * Vector2f(cosf(s->_curAngle), sinf(s->_curAngle));
+    LineShape ll2(pos, pt);
+    ll2.setFillColor(Color::Yellow);
+    window->draw(ll2);
+
+  }
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "types.hpp"
+
+namespace pang
+{
+  class EntityStore;
+
+  // Draws an entity's behavior state. The renderers are owned by the game, keyed by the
+  // entity's id, as entities move between slots
+  struct DebugRenderer
+  {
+    DebugRenderer(const EntityStore* entities, EntityId id) : _entities(entities), _id(id) {}
+    virtual ~DebugRenderer() {};
+    const EntityStore* _entities;
+    EntityId _id;
+    virtual void Render(RenderWindow* window) = 0;
+  };
+
+  struct PursuitDebugRenderer : public DebugRenderer
+  {
+    PursuitDebugRenderer(const EntityStore* entities, EntityId id) : DebugRenderer(entities, id) {}
+    virtual void Render(RenderWindow* window);
+  };
+
+  struct WanderDebugRenderer : public DebugRenderer
+  {
+    WanderDebugRenderer(const EntityStore* entities, EntityId id) : DebugRenderer(entities, id) {}
+    virtual void Render(RenderWindow* window);
+  };
+}
@@ -1,35 +1,169 @@
 #include "entity.hpp"
-#include "behavior.hpp"
 
 using namespace pang;
 
+const u32 EntityCold::NO_ACTION;
+const u32 EntityStore::INVALID_SLOT;
+
 //----------------------------------------------------------------------------------
-Entity::Entity(EntityId id, const Vector2f& pos)
-    : _id(id)
-    , _pos(pos)
-    , _prevPos(pos)
-    , _vel(0,0)
-    , _acc(0,0)
-    , _force(0,0)
-    , _debug(nullptr)
-    , _mass(1.0f + (float)rand() / RAND_MAX)
-    , _invMass(1/_mass)
-    , _rot(0)
-    , _fov(PI / 6)
-    , _viewDistance(500)
-    , _collision(false)
+EntityCold::EntityCold()
+    : _mass(1.0f + (float)rand() / RAND_MAX)
+    , _lastActionTick(NO_ACTION)
 {
 }
 
 //----------------------------------------------------------------------------------
-Entity::~Entity()
+EntityId EntityStore::Add(const Vector2f& pos, u32* slot)
 {
-  delete exch_null(_debug);
+  u32 index;
+  if (_freeIndices.size() > MIN_FREE_INDICES || (_slots.size() == MAX_ENTITIES && !_freeIndices.empty()))
+  {
+    index = _freeIndices.front();
+    _freeIndices.pop_front();
+  }
+  else if (_slots.size() < MAX_ENTITIES)
+  {
+    index = (u32)_slots.size();
+    _slots.push_back(INVALID_SLOT);
+    _generations.push_back(1);
+  }
+  else
+  {
+    return NO_ENTITY;
+  }
+
+  EntityId id = ((u32)_generations[index] << ENTITY_INDEX_BITS) | index;
+  *slot = Size();
+  _slots[index] = *slot;
+
+  _cold.emplace_back();
+  _id.push_back(id);
+  _pos.push_back(pos);
+  _prevPos.push_back(pos);
+  _vel.push_back(Vector2f(0,0));
+  _force.push_back(Vector2f(0,0));
+  _invMass.push_back(1 / _cold.back()._mass);
+  _rot.push_back(0);
+  _fov.push_back(PI / 6);
+  _viewDistance.push_back(500);
+  _squadId.push_back(NO_SQUAD);
+  _collision.push_back(0);
+  return id;
+}
+
+//----------------------------------------------------------------------------------
+void EntityStore::Remove(u32 slot)
+{
+  FreeHandle(slot);
+
+  u32 last = Size() - 1;
+  if (slot != last)
+    Move(last, slot);
+
+  Resize(last);
 }
 
 //----------------------------------------------------------------------------------
-Vector2f Entity::Dir() const
+void EntityStore::Remove(const vector<u32>& slots)
 {
-  return Vector2f(sinf(_rot), -cosf(_rot));
+  if (slots.empty())
+    return;
+
+  for (u32 slot : slots)
+    FreeHandle(slot);
+
+  // shift the survivors down over the removed slots
+  u32 dst = slots.front();
+  size_t next = 0;
+  for (u32 src = dst, n = Size(); src < n; ++src)
+  {
+    if (next < slots.size() && slots[next] == src)
+    {
+      ++next;
+      continue;
+    }
+
+    Move(src, dst++);
+  }
+
+  Resize(dst);
 }
 
+//----------------------------------------------------------------------------------
+void EntityStore::Reorder(const vector<u32>& order)
+{
+  assert(order.size() == Size());
+
+  Permute(order, &_id, &_scratchU32);
+  Permute(order, &_pos, &_scratchVector2f);
+  Permute(order, &_prevPos, &_scratchVector2f);
+  Permute(order, &_vel, &_scratchVector2f);
+  Permute(order, &_force, &_scratchVector2f);
+  Permute(order, &_invMass, &_scratchFloat);
+  Permute(order, &_rot, &_scratchFloat);
+  Permute(order, &_fov, &_scratchFloat);
+  Permute(order, &_viewDistance, &_scratchFloat);
+  Permute(order, &_squadId, &_scratchU16);
+  Permute(order, &_collision, &_scratchU8);
+  Permute(order, &_cold, &_scratchCold);
+
+  for (u32 slot = 0, n = Size(); slot < n; ++slot)
+    _slots[EntityIndex(_id[slot])] = slot;
+}
+
+//----------------------------------------------------------------------------------
+void EntityStore::FreeHandle(u32 slot)
+{
+  u32 index = EntityIndex(_id[slot]);
+  _slots[index] = INVALID_SLOT;
+  // skip generation 0 when wrapping, so NO_ENTITY never resolves
+  u32 generation = (_generations[index] + 1) & ((1 << ENTITY_GENERATION_BITS) - 1);
+  _generations[index] = (u16)max(generation, 1u);
+  _freeIndices.push_back(index);
+}
+
+//----------------------------------------------------------------------------------
+void EntityStore::Move(u32 from, u32 to)
+{
+  _slots[EntityIndex(_id[from])] = to;
+  _id[to] = _id[from];
+  _pos[to] = _pos[from];
+  _prevPos[to] = _prevPos[from];
+  _vel[to] = _vel[from];
+  _force[to] = _force[from];
+  _invMass[to] = _invMass[from];
+  _rot[to] = _rot[from];
+  _fov[to] = _fov[from];
+  _viewDistance[to] = _viewDistance[from];
+  _squadId[to] = _squadId[from];
+  _collision[to] = _collision[from];
+  _cold[to] = std::move(_cold[from]);
+}
+
+//----------------------------------------------------------------------------------
+void EntityStore::Resize(u32 size)
+{
+  _id.resize(size);
+  _pos.resize(size);
+  _prevPos.resize(size);
+  _vel.resize(size);
+  _force.resize(size);
+  _invMass.resize(size);
+  _rot.resize(size);
+  _fov.resize(size);
+  _viewDistance.resize(size);
+  _squadId.resize(size);
+  _collision.resize(size);
+  _cold.resize(size);
+}
+
+//----------------------------------------------------------------------------------
+bool EntityStore::Find(EntityId id, u32* slot) const
+{
+  u32 index = EntityIndex(id);
+  if (index >= _slots.size() || _slots[index] == INVALID_SLOT || _generations[index] != EntityGeneration(id))
+    return false;
+
+  *slot = _slots[index];
+  return true;
+}
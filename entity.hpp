@@ -3,37 +3,101 @@
 
 namespace pang
 {
-  struct DebugRenderer;
-
   struct Squad
   {
     u16 _id;
   };
 
-  struct Entity
+  // The per entity data the per tick loops don't touch
+  struct EntityCold
   {
-    Entity(EntityId id, const Vector2f& pos);
-    ~Entity();
-    Vector2f Dir() const;
-    bool ReadCollision() const { bool tmp = _collision; _collision = false; return tmp; }
-    EntityId _id;
-    Vector2f _pos;
-    Vector2f _prevPos;
-    Vector2f _vel;
-    Vector2f _acc;
-    Vector2f _force;
-    DebugRenderer* _debug;
+    EntityCold();
+
     float _mass;
-    float _invMass;
+    // the physics tick of the last shot. NO_ACTION before the first one
+    static const u32 NO_ACTION = ~0u;
+    u32 _lastActionTick;
+    // where the last pursuit was headed, for the game's debug renderer. written by the
+    // (const) behaviors
+    mutable Vector2f _lookAhead;
+  };
+
+  // Dense structure of arrays entity storage. The fields the per tick loops touch each
+  // get a contiguous array, indexed by the entity's slot, and the rest goes in a side
+  // table. Removing an entity moves the last one into its slot to keep the arrays dense,
+  // so slots aren't stable across removals, and entities are looked up by id.
+  // The id's index refers to an entry in the handle table holding the entity's slot.
+  // Removing an entity bumps its entry's generation, so an id kept after the entity is
+  // gone (a selection, a visible list) no longer resolves. Freed entries are reused
+  // oldest first, and only once MIN_FREE_INDICES are waiting, so an entry goes through
+  // its generations slowly
+  class EntityStore
+  {
+  public:
+    enum { MAX_ENTITIES = 1 << ENTITY_INDEX_BITS, MIN_FREE_INDICES = 1024 };
+    static const u32 INVALID_SLOT = ~0u;
+
+    // returns the new entity's id, and its slot in *slot, or NO_ENTITY if the store is full
+    EntityId Add(const Vector2f& pos, u32* slot);
+    void Remove(u32 slot);
+    // removes the entities in the (ascending) slots in one pass. unlike Remove, the
+    // remaining entities keep their order
+    void Remove(const vector<u32>& slots);
+    // moves the entity in slot order[i] to slot i, for every slot. the ids don't change
+    void Reorder(const vector<u32>& order);
+
+    // false if the entity has been removed, or the id is NO_ENTITY
+    bool Find(EntityId id, u32* slot) const;
+    bool IsAlive(EntityId id) const { u32 slot; return Find(id, &slot); }
+    u32 Size() const { return (u32)_id.size(); }
+    bool Empty() const { return _id.empty(); }
+    // the size of the handle table, live and free entries
+    u32 NumHandles() const { return (u32)_slots.size(); }
+
     // 0 points straight up, and rotates clockwise. In SFML, (0,-1) points straight up
-    float _rot;
-    ptime _lastAction;
+    Vector2f Dir(u32 slot) const { return Vector2f(sinf(_rot[slot]), -cosf(_rot[slot])); }
+
+    // hot fields
+    vector<EntityId> _id;
+    vector<Vector2f> _pos;
+    vector<Vector2f> _prevPos;
+    vector<Vector2f> _vel;
+    vector<Vector2f> _force;
+    vector<float> _invMass;
+    vector<float> _rot;
     // fov is symmetric along the direction vector
-    float _fov;
-    float _viewDistance;
-    SquadId _squadId;
-    mutable bool _collision;
+    vector<float> _fov;
+    vector<float> _viewDistance;
+    vector<SquadId> _squadId;
+    vector<u8> _collision;
+
+    vector<EntityCold> _cold;
+
+  private:
+    void FreeHandle(u32 slot);
+    void Move(u32 from, u32 to);
+    void Resize(u32 size);
+
+    template <typename T>
+    static void Permute(const vector<u32>& order, vector<T>* values, vector<T>* scratch)
+    {
+      scratch->clear();
+      for (u32 from : order)
+        scratch->push_back(std::move((*values)[from]));
+      values->swap(*scratch);
+    }
+
+    // per handle table entry
+    vector<u32> _slots;
+    vector<u16> _generations;
+    deque<u32> _freeIndices;
 
-    vector<EntityId> _visibleEntities;
+    // reused by Reorder, so a reorder doesn't allocate once they've grown
+    vector<u32> _scratchU32;
+    vector<u16> _scratchU16;
+    vector<u8> _scratchU8;
+    vector<float> _scratchFloat;
+    vector<Vector2f> _scratchVector2f;
+    vector<EntityCold> _scratchCold;
   };
 }
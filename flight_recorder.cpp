@@ -0,0 +1,584 @@
+#include "flight_recorder.hpp"
+
+using namespace pang;
+
+namespace pang
+{
+  FlightRecorder g_flightRecorder;
+}
+
+namespace
+{
+  const char FILE_MAGIC[8] = { 'P', 'A', 'N', 'G', 'F', 'L', 'T', '1' };
+
+  struct FileHeader
+  {
+    char magic[8];
+    u32 numBlocks;
+    u32 pad;
+    u64 tickUs;
+  };
+
+  // fixed point scales for the fields. positions are in pixels, velocities in pixels
+  // per ms, and rotations in radians
+  const float SCALES[FlightRecorder::NUM_FIELDS] =
+  {
+    16, 16,
+    4096, 4096,
+    1 << 24, 1 << 24,
+    65536 / (2 * PI),
+    1,
+  };
+
+  //----------------------------------------------------------------------------------
+  s32 Quantize(float v, float scale)
+  {
+    float s = v * scale;
+    return (s32)(s < 0 ? s - 0.5f : s + 0.5f);
+  }
+
+  //----------------------------------------------------------------------------------
+  u8* WriteVarint(u8* p, s32 v)
+  {
+    // zigzag, so small negative deltas stay small
+    u32 u = ((u32)v << 1) ^ (u32)(v >> 31);
+    while (u >= 0x80)
+    {
+      *p++ = (u8)(u | 0x80);
+      u >>= 7;
+    }
+    *p++ = (u8)u;
+    return p;
+  }
+
+  //----------------------------------------------------------------------------------
+  const u8* ReadVarint(const u8* p, const u8* end, s32* v)
+  {
+    u32 u = 0;
+    for (u32 shift = 0; p < end && shift < 35; shift += 7)
+    {
+      u8 b = *p++;
+      u |= (u32)(b & 0x7f) << shift;
+      if (!(b & 0x80))
+      {
+        *v = (s32)(u >> 1) ^ -(s32)(u & 1);
+        return p;
+      }
+    }
+    return nullptr;
+  }
+
+  //----------------------------------------------------------------------------------
+  bool WriteAll(int fd, const void* data, size_t size)
+  {
+    const char* p = (const char*)data;
+    while (size > 0)
+    {
+      int n = (int)write(fd, p, (u32)size);
+      if (n <= 0)
+        return false;
+      p += n;
+      size -= n;
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------------
+  int OpenForWrite(const char* filename)
+  {
+#ifdef _WIN32
+    return open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+#else
+    return open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+  }
+}
+
+//----------------------------------------------------------------------------------
+FlightRecorder::FlightRecorder()
+    : _writeOffset(0)
+    , _firstBlock(0)
+    , _numBlocks(0)
+    , _keyframe(0)
+    , _numRecorded(0)
+    , _numDropped(0)
+    , _tickUs(0)
+    , _recordInterval(1)
+    , _pending(false)
+    , _encoding(false)
+    , _done(false)
+{
+  _crashFile[0] = 0;
+}
+
+//----------------------------------------------------------------------------------
+FlightRecorder::~FlightRecorder()
+{
+  Stop();
+}
+
+//----------------------------------------------------------------------------------
+bool FlightRecorder::Start(u32 bufferBytes, u64 tickUs)
+{
+  if (IsRecording() || bufferBytes < sizeof(BlockHeader))
+    return false;
+
+  _buffer.resize(bufferBytes);
+  _blocks.resize(MAX_BLOCKS);
+  _writeOffset = 0;
+  _firstBlock = 0;
+  _numBlocks = 0;
+  _bases.clear();
+  _keyframe = 0;
+  _numRecorded = 0;
+  _numDropped = 0;
+  _tickUs = tickUs;
+  _recordInterval = max<u32>(1, (u32)(1000000 / RECORD_HZ / tickUs));
+  _pending = false;
+  _encoding = false;
+  _done = false;
+  _thread = thread(&FlightRecorder::EncoderThread, this);
+  return true;
+}
+
+//----------------------------------------------------------------------------------
+void FlightRecorder::Stop()
+{
+#ifndef _WIN32
+  if (_crashFile[0])
+  {
+    int signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+    for (int sig : signals)
+      signal(sig, SIG_DFL);
+    _crashFile[0] = 0;
+  }
+#endif
+
+  if (_thread.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _done = true;
+    }
+    _cv.notify_all();
+    _thread.join();
+  }
+
+  if (_numDropped)
+    printf("flight recorder dropped %u ticks\n", (u32)_numDropped);
+  _numDropped = 0;
+
+  _buffer.clear();
+  _buffer.shrink_to_fit();
+  _numBlocks = 0;
+}
+
+//----------------------------------------------------------------------------------
+void FlightRecorder::EvictBlocks(u32 offset, u32 size)
+{
+  // blocks are written in ring order, so the oldest block is the next one to be
+  // overwritten
+  while (_numBlocks > 0)
+  {
+    const Block& b = _blocks[_firstBlock];
+    if (b.offset >= offset + size || b.offset + b.size <= offset)
+      break;
+    _firstBlock = (_firstBlock + 1) % MAX_BLOCKS;
+    --_numBlocks;
+  }
+}
+
+//----------------------------------------------------------------------------------
+void FlightRecorder::Record(u32 tick, const EntityStore& entities, const VisibilityResults& visibility)
+{
+  if (_buffer.empty() || tick % _recordInterval != 0)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_pending)
+    {
+      ++_numDropped;
+      return;
+    }
+  }
+
+  // only copy the fields here, the encoder thread does the rest
+  Frame& frame = _frame;
+  frame.tick = tick;
+  frame.ids = entities._id;
+  frame.pos = entities._pos;
+  frame.vel = entities._vel;
+  frame.force = entities._force;
+  frame.rot = entities._rot;
+  frame.collision = entities._collision;
+  frame.visibility = visibility;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pending = true;
+  }
+  _cv.notify_all();
+}
+
+//----------------------------------------------------------------------------------
+void FlightRecorder::EncoderThread()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true)
+  {
+    _cv.wait(lock, [this] { return _pending || _done; });
+    if (!_pending)
+      break;
+
+    std::swap(_frame, _encodeFrame);
+    _pending = false;
+    _encoding = true;
+
+    lock.unlock();
+    Encode(_encodeFrame);
+    lock.lock();
+
+    _encoding = false;
+    _cv.notify_all();
+  }
+}
+
+//----------------------------------------------------------------------------------
+void FlightRecorder::WaitIdle()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  _cv.wait(lock, [this] { return !_pending && !_encoding; });
+}
+
+//----------------------------------------------------------------------------------
+void FlightRecorder::Encode(const Frame& frame)
+{
+  // worst case of 5 bytes per varint
+  u32 n = (u32)frame.ids.size();
+  u32 maxSize = sizeof(BlockHeader) + n * 5 * (1 + NUM_FIELDS) + (n + 7) / 8;
+  if (maxSize > _buffer.size())
+  {
+    ++_numDropped;
+    return;
+  }
+
+  bool keyframe = _numRecorded % KEYFRAME_INTERVAL == 0;
+  if (keyframe)
+    ++_keyframe;
+
+  for (vector<s32>& column : _columns)
+    column.resize(n);
+  _collisions.assign((n + 7) / 8, 0);
+
+  // quantize, and delta against the entity's previous recorded tick, into the columns
+  for (u32 i = 0; i < n; ++i)
+  {
+    EntityId id = frame.ids[i];
+    float values[NUM_FIELDS] =
+    {
+      frame.pos[i].x, frame.pos[i].y,
+      frame.vel[i].x, frame.vel[i].y,
+      frame.force[i].x, frame.force[i].y,
+      frame.rot[i],
+      (float)frame.visibility.NumVisible(id),
+    };
+
+    u32 index = EntityIndex(id);
+    if (index >= _bases.size())
+      _bases.resize(max<size_t>(index + 1, 2 * _bases.size()));
+
+    Base& base = _bases[index];
+    bool hasBase = base.keyframe == _keyframe && base.id == id;
+    for (int f = 0; f < NUM_FIELDS; ++f)
+    {
+      s32 q = Quantize(values[f], SCALES[f]);
+      _columns[f][i] = hasBase ? (s32)((u32)q - (u32)base.values[f]) : q;
+      base.values[f] = q;
+    }
+    base.keyframe = _keyframe;
+    base.id = id;
+
+    if (frame.collision[i])
+      _collisions[i >> 3] |= 1 << (i & 7);
+  }
+
+  // blocks are never split, so wrap around if the block might not fit
+  u32 offset = _writeOffset;
+  if (offset + maxSize > _buffer.size())
+  {
+    EvictBlocks(offset, (u32)_buffer.size() - offset);
+    offset = 0;
+  }
+  EvictBlocks(offset, maxSize);
+
+  u8* start = &_buffer[offset];
+  u8* p = start + sizeof(BlockHeader);
+  u32 prevId = 0;
+  for (u32 j = 0; j < n; ++j)
+  {
+    p = WriteVarint(p, (s32)((u32)frame.ids[j] - prevId));
+    prevId = frame.ids[j];
+  }
+
+  for (const vector<s32>& column : _columns)
+  {
+    for (u32 j = 0; j < n; ++j)
+      p = WriteVarint(p, column[j]);
+  }
+
+  memcpy(p, _collisions.data(), _collisions.size());
+  p += _collisions.size();
+
+  BlockHeader header = { (u32)(p - start), frame.tick, n, keyframe };
+  memcpy(start, &header, sizeof(header));
+  _writeOffset = offset + header.size;
+
+  if (_numBlocks == MAX_BLOCKS)
+  {
+    _firstBlock = (_firstBlock + 1) % MAX_BLOCKS;
+    --_numBlocks;
+  }
+
+  Block block = { offset, header.size, frame.tick, keyframe };
+  _blocks[(_firstBlock + _numBlocks) % MAX_BLOCKS] = block;
+  ++_numBlocks;
+  ++_numRecorded;
+}
+
+//----------------------------------------------------------------------------------
+bool FlightRecorder::WriteBlocks(int fd, u32 firstBlock) const
+{
+  FileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+  header.numBlocks = _numBlocks - firstBlock;
+  header.tickUs = _tickUs;
+  if (!WriteAll(fd, &header, sizeof(header)))
+    return false;
+
+  for (u32 i = firstBlock; i < _numBlocks; ++i)
+  {
+    const Block& b = _blocks[(_firstBlock + i) % MAX_BLOCKS];
+    if (!WriteAll(fd, &_buffer[b.offset], b.size))
+      return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------------
+bool FlightRecorder::Dump(const string& filename, float numSeconds)
+{
+  if (_buffer.empty())
+    return false;
+
+  WaitIdle();
+  if (_numBlocks == 0)
+    return false;
+
+  // start at the last keyframe before the range, or the oldest one if the range goes
+  // further back than the ring
+  u32 newestTick = _blocks[(_firstBlock + _numBlocks - 1) % MAX_BLOCKS].tick;
+  u32 numTicks = numSeconds > 0 ? (u32)(numSeconds * 1e6 / _tickUs) : ~0u;
+  u32 first = _numBlocks;
+  for (u32 i = 0; i < _numBlocks; ++i)
+  {
+    const Block& b = _blocks[(_firstBlock + i) % MAX_BLOCKS];
+    if (!b.keyframe)
+      continue;
+
+    if (first == _numBlocks || newestTick - b.tick >= numTicks)
+      first = i;
+    else
+      break;
+  }
+
+  if (first == _numBlocks)
+    return false;
+
+  int fd = OpenForWrite(filename.c_str());
+  if (fd == -1)
+    return false;
+
+  bool res = WriteBlocks(fd, first);
+  close(fd);
+
+  const Block& b = _blocks[(_firstBlock + first) % MAX_BLOCKS];
+  printf("wrote %u flight recorder ticks (%.1f s) to %s\n",
+      _numBlocks - first, (newestTick - b.tick + 1) * _tickUs / 1e6, filename.c_str());
+  return res;
+}
+
+//----------------------------------------------------------------------------------
+bool FlightRecorder::DumpOnCrash(const string& filename)
+{
+#ifdef _WIN32
+  printf("flight recorder crash dumps aren't supported on windows\n");
+  return false;
+#else
+  if (filename.size() >= sizeof(_crashFile))
+    return false;
+
+  strcpy(_crashFile, filename.c_str());
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = &FlightRecorder::OnCrash;
+  // the default handler is restored on entry, so re-raising the signal terminates
+  sa.sa_flags = SA_RESETHAND;
+  sigemptyset(&sa.sa_mask);
+
+  int signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+  for (int sig : signals)
+  {
+    if (sigaction(sig, &sa, nullptr) != 0)
+      return false;
+  }
+
+  return true;
+#endif
+}
+
+//----------------------------------------------------------------------------------
+void FlightRecorder::OnCrash(int sig)
+{
+#ifndef _WIN32
+  // only async signal safe calls from here, so the whole ring is written, starting
+  // at the oldest keyframe. the encoder may be mid block, but a block is only added
+  // to the list once it's written, and blocks are evicted before being overwritten
+  const FlightRecorder& r = g_flightRecorder;
+  for (u32 i = 0; i < r._numBlocks; ++i)
+  {
+    if (!r._blocks[(r._firstBlock + i) % MAX_BLOCKS].keyframe)
+      continue;
+
+    int fd = OpenForWrite(r._crashFile);
+    if (fd != -1)
+    {
+      r.WriteBlocks(fd, i);
+      close(fd);
+    }
+    break;
+  }
+
+  raise(sig);
+#endif
+}
+
+//----------------------------------------------------------------------------------
+bool FlightRecorder::WriteCsv(const string& dumpFile, const string& csvFile)
+{
+  FILE* in = fopen(dumpFile.c_str(), "rb");
+  if (!in)
+    return false;
+
+  vector<char> buf;
+  char chunk[64 * 1024];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+    buf.insert(buf.end(), chunk, chunk + n);
+  fclose(in);
+
+  FileHeader header;
+  if (buf.size() < sizeof(header))
+    return false;
+
+  memcpy(&header, buf.data(), sizeof(header));
+  if (memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0)
+  {
+    printf("%s isn't a flight recorder dump\n", dumpFile.c_str());
+    return false;
+  }
+
+  FILE* f = fopen(csvFile.c_str(), "w");
+  if (!f)
+    return false;
+
+  fprintf(f, "tick,id,pos_x,pos_y,vel_x,vel_y,force_x,force_y,rot,visible,collision\n");
+
+  // mirrors the encoder's delta state
+  vector<Base> bases;
+  vector<EntityId> ids;
+  vector<s32> values;
+  u32 keyframe = 0;
+
+  const u8* p = (const u8*)buf.data() + sizeof(header);
+  const u8* end = (const u8*)buf.data() + buf.size();
+  bool res = true;
+  for (u32 i = 0; i < header.numBlocks && res; ++i)
+  {
+    BlockHeader block;
+    if (end - p < (ptrdiff_t)sizeof(block))
+    {
+      res = false;
+      break;
+    }
+
+    memcpy(&block, p, sizeof(block));
+    const u8* blockEnd = p + block.size;
+    if (block.size < sizeof(block) || blockEnd > end)
+    {
+      res = false;
+      break;
+    }
+
+    if (block.keyframe)
+      ++keyframe;
+
+    u32 n = block.numEntities;
+    const u8* q = p + sizeof(block);
+    ids.resize(n);
+    values.resize(n * NUM_FIELDS);
+
+    u32 prevId = 0;
+    for (u32 j = 0; j < n && q; ++j)
+    {
+      s32 delta = 0;
+      q = ReadVarint(q, blockEnd, &delta);
+      ids[j] = prevId + (u32)delta;
+      prevId = ids[j];
+    }
+
+    for (u32 f = 0; f < NUM_FIELDS && q; ++f)
+    {
+      for (u32 j = 0; j < n && q; ++j)
+        q = ReadVarint(q, blockEnd, &values[j * NUM_FIELDS + f]);
+    }
+
+    if (!q || blockEnd - q != (ptrdiff_t)(n + 7) / 8)
+    {
+      res = false;
+      break;
+    }
+
+    for (u32 j = 0; j < n; ++j)
+    {
+      EntityId id = ids[j];
+      u32 index = EntityIndex(id);
+      if (index >= bases.size())
+        bases.resize(max<size_t>(index + 1, 2 * bases.size()));
+
+      Base& base = bases[index];
+      bool hasBase = base.keyframe == keyframe && base.id == id;
+      fprintf(f, "%u,%u", block.tick, id);
+      for (u32 k = 0; k < NUM_FIELDS; ++k)
+      {
+        s32 delta = values[j * NUM_FIELDS + k];
+        base.values[k] = hasBase ? (s32)((u32)base.values[k] + (u32)delta) : delta;
+        fprintf(f, ",%g", base.values[k] / SCALES[k]);
+      }
+      base.keyframe = keyframe;
+      base.id = id;
+      fprintf(f, ",%d\n", (q[j >> 3] >> (j & 7)) & 1);
+    }
+
+    p = blockEnd;
+  }
+
+  fclose(f);
+
+  if (!res)
+    printf("%s is truncated or corrupt\n", dumpFile.c_str());
+  return res;
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include "types.hpp"
+#include "simulation.hpp"
+#include "visibility.hpp"
+
+namespace pang
+{
+  // Fields recorded per entity, quantized to fixed point
+  enum class FlightField
+  {
+    PosX,
+    PosY,
+    VelX,
+    VelY,
+    ForceX,
+    ForceY,
+    Rot,
+    NumVisible,
+    FieldCount,
+  };
+
+  // Flight recorder of the entity state at the start of the physics tick, RECORD_HZ
+  // times a second, so there is some history when an ai bug or a hitch shows up late
+  // in a session.
+  // The game thread only copies the raw fields of a recorded tick into a frame; an
+  // encoder thread stores it as a block in a fixed size byte ring, oldest overwritten
+  // first. A tick is dropped if the encoder is still busy with the previous one. Each
+  // block is columnar: the entity ids, then one column per field, then the collision
+  // flags as a bitset. Fields are quantized, and stored as zigzag varint deltas from
+  // the entity's value in its previous recorded tick, with every KEYFRAME_INTERVAL'th
+  // block delta encoded from 0, so a dump can be decoded from its first block.
+  // The dump is a short header followed by the blocks as stored
+  class FlightRecorder
+  {
+  public:
+    enum
+    {
+      RECORD_HZ = 10,
+      KEYFRAME_INTERVAL = 64,
+      MAX_BLOCKS = 1 << 16,
+      NUM_FIELDS = (int)FlightField::FieldCount
+    };
+
+    FlightRecorder();
+    ~FlightRecorder();
+
+    bool Start(u32 bufferBytes, u64 tickUs);
+    void Stop();
+    bool IsRecording() const { return !_buffer.empty(); }
+
+    void Record(u32 tick, const EntityStore& entities, const VisibilityResults& visibility);
+
+    // writes the blocks covering the last numSeconds (or everything, if 0), once the
+    // encoder has caught up
+    bool Dump(const string& filename, float numSeconds);
+    // dumps everything to filename if the process crashes. not available on windows
+    bool DumpOnCrash(const string& filename);
+
+    // writes a dump as csv, one row per entity and tick
+    static bool WriteCsv(const string& dumpFile, const string& csvFile);
+
+  private:
+    struct BlockHeader
+    {
+      u32 size;
+      u32 tick;
+      u32 numEntities;
+      u32 keyframe;
+    };
+
+    struct Block
+    {
+      u32 offset;
+      u32 size;
+      u32 tick;
+      bool keyframe;
+    };
+
+    // the last recorded values of an entity, and the keyframe they were recorded in.
+    // bases are indexed by the id's index, so the id tells a reused index apart
+    struct Base
+    {
+      s32 values[NUM_FIELDS];
+      u32 keyframe;
+      EntityId id;
+    };
+
+    // the raw state of a recorded tick, one entry per entity
+    struct Frame
+    {
+      u32 tick;
+      vector<EntityId> ids;
+      vector<Vector2f> pos;
+      vector<Vector2f> vel;
+      vector<Vector2f> force;
+      vector<float> rot;
+      VisibilityResults visibility;
+      vector<u8> collision;
+    };
+
+    static void OnCrash(int sig);
+    bool WriteBlocks(int fd, u32 firstBlock) const;
+    void EvictBlocks(u32 offset, u32 size);
+    void EncoderThread();
+    void Encode(const Frame& frame);
+    void WaitIdle();
+
+    vector<u8> _buffer;
+    u32 _writeOffset;
+
+    // the blocks in the ring, oldest first
+    vector<Block> _blocks;
+    u32 _firstBlock;
+    u32 _numBlocks;
+
+    vector<Base> _bases;
+    u32 _keyframe;
+    u32 _numRecorded;
+    atomic<u32> _numDropped;
+    u64 _tickUs;
+    u32 _recordInterval;
+
+    // per field deltas of the block being encoded, reused between blocks
+    vector<s32> _columns[NUM_FIELDS];
+    vector<u8> _collisions;
+
+    // the game thread fills _frame, and hands it over by setting _pending. the encoder
+    // swaps it with _encodeFrame, so the next tick can be copied while it encodes
+    Frame _frame;
+    Frame _encodeFrame;
+    bool _pending;
+    bool _encoding;
+    bool _done;
+    thread _thread;
+    std::mutex _mutex;
+    condition_variable _cv;
+
+    char _crashFile[256];
+  };
+
+  extern FlightRecorder g_flightRecorder;
+}
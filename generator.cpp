@@ -0,0 +1,120 @@
+#include "generator.hpp"
+
+using namespace pang;
+using namespace bristol;
+
+//----------------------------------------------------------------------------------
+Generator::~Generator()
+{
+  for (Room* r : _rooms)
+    delete r;
+
+  for (Partition* p : _partitions)
+    delete p;
+}
+
+//----------------------------------------------------------------------------------
+void Generator::Run(const pang::level::Level& config)
+{
+  _config = config;
+
+  // the bounds are retracted to allow for a 1 pixel wall
+  _bounds = Rect(1, 1, config.width() - 3, config.height() - 3);
+
+  // add the global partition
+  _partitions.push_back(new Partition(_bounds));
+  RunInner(_partitions.back());
+}
+
+//----------------------------------------------------------------------------------
+void Generator::RunInner(Partition* parent)
+{
+  if (/*_rooms.size() >= _config.num_rooms()*/ false
+      || parent->_bounds.width <= _config.min_room_width()
+      || parent->_bounds.height <= _config.min_room_height())
+  {
+    return;
+  }
+
+  _rooms.push_back(CreateRoom(parent));
+  for (int i = 0; i < 4; ++i)
+  {
+    if (Partition* p = parent->_partitions[i])
+    {
+      RunInner(p);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------
+void Generator::AddPartition(Partition* parent, Partition::Location loc, const Rect& bounds)
+{
+  Partition* p = new Partition(bounds);
+  _partitions.push_back(p);
+  parent->_partitions[loc] = p;
+}
+
+//----------------------------------------------------------------------------------
+Room* Generator::CreateRoom(Partition* parent)
+{
+  // create a room inside the given bounds
+  u32 id = _rooms.size();
+  Room* room = new Room(id);
+
+  int width = randf(_config.min_room_width(), min(_config.max_room_width(), parent->_bounds.width));
+  int height = randf(_config.min_room_height(), min(_config.max_room_height(), parent->_bounds.height));
+  room->_bounds.width = width;
+  room->_bounds.height = height;
+
+  // extract bounding dimensions
+  int bleft   = parent->_bounds.left;
+  int bright  = bleft + parent->_bounds.width;
+  int btop    = parent->_bounds.top;
+  int bbottom = btop + parent->_bounds.height;
+  int bwidth  = parent->_bounds.width;
+  int bheight = parent->_bounds.height;
+  int rwidth  = bwidth - width;
+  int rheight = bheight - height;
+
+  // choose starting corner
+  switch (rand() % 4)
+  {
+    // top left
+    case 0:
+      parent->_rooms[Partition::TopLeft] = room;
+      room->_bounds.top = btop;
+      room->_bounds.left = bleft;
+      AddPartition(parent, Partition::South, Rect(bleft, btop + height, width, rheight));
+      AddPartition(parent, Partition::East, Rect(bleft + width, btop, rwidth, bheight));
+      break;
+
+    // top right
+    case 1:
+      parent->_rooms[Partition::TopRight] = room;
+      room->_bounds.top = btop;
+      room->_bounds.left = bright - width + 1;
+      AddPartition(parent, Partition::West, Rect(bleft, btop, rwidth, bheight));
+      AddPartition(parent, Partition::South, Rect(bright - width, btop + height, width, rheight));
+      break;
+
+    // bottom left
+    case 2:
+      parent->_rooms[Partition::BottomLeft] = room;
+      room->_bounds.top = bbottom - height;
+      room->_bounds.left = bleft;
+      AddPartition(parent, Partition::North, Rect(bleft, btop, width, rheight));
+      AddPartition(parent, Partition::East, Rect(bleft + width, btop, rwidth, bheight));
+      break;
+
+    // bottom right
+    case 3:
+      parent->_rooms[Partition::BottomRight] = room;
+      room->_bounds.top = bbottom - height;
+      room->_bounds.left = bright - width;
+      AddPartition(parent, Partition::West, Rect(bleft, btop, rwidth, bheight));
+      AddPartition(parent, Partition::North, Rect(bright - width, btop, width, rheight));
+      break;
+  }
+
+  return room;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "types.hpp"
+#include "protocol/level.pb.h"
+
+namespace pang
+{
+  // BSP room generator used by Level
+  struct Room;
+
+  // same layout as Rect, which lives in sfml-graphics
+  struct Rect
+  {
+    Rect() : left(0), top(0), width(0), height(0) {}
+    Rect(int left, int top, int width, int height) : left(left), top(top), width(width), height(height) {}
+    int left, top, width, height;
+  };
+
+  struct Partition
+  {
+    enum Location
+    {
+      North,
+      South,
+      East,
+      West,
+    };
+
+    enum Corner
+    {
+      TopLeft, TopRight, BottomLeft, BottomRight,
+    };
+
+    Partition(const Rect& bounds)
+        : _bounds(bounds)
+    {
+      memset(_rooms, 0, sizeof(_rooms));
+      memset(_partitions, 0, sizeof(_partitions));
+    }
+
+    Rect _bounds;
+    Room* _rooms[4];
+    Partition* _partitions[4];
+  };
+
+  struct Room
+  {
+    Room(u32 id) : _id(id) {}
+    u32 _id;
+    Rect _bounds;
+  };
+
+  struct Generator
+  {
+    ~Generator();
+    // level generator based on: http://www.moddb.com/games/frozen-synapse/news/frozen-synapse-procedural-level-generation
+    void Run(const pang::level::Level& config);
+    void RunInner(Partition* parent);
+    Room* CreateRoom(Partition* parent);
+
+    void AddPartition(Partition* parent, Partition::Location loc, const Rect& bounds);
+
+    pang::level::Level _config;
+    Rect _bounds;
+    vector<Room*> _rooms;
+    vector<Partition*> _partitions;
+  };
+}
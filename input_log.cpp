@@ -0,0 +1,139 @@
+#include "input_log.hpp"
+
+using namespace pang;
+
+namespace
+{
+  const char INPUT_MAGIC[8] = { 'P', 'A', 'N', 'G', 'I', 'N', 'P', '1' };
+
+  // per frame, the flags hold whether the simulation was updated in bit 7, and the
+  // number of events in the low bits
+  const u8 FLAG_UPDATED = 0x80;
+  const u8 MAX_EVENTS = 0x7f;
+}
+
+//----------------------------------------------------------------------------------
+InputLog::InputLog()
+    : _file(nullptr)
+    , _seed(0)
+    , _numFrames(0)
+{
+}
+
+//----------------------------------------------------------------------------------
+InputLog::~InputLog()
+{
+  Close();
+}
+
+//----------------------------------------------------------------------------------
+bool InputLog::OpenWrite(const string& filename, u32 seed, const string& configFile)
+{
+  if (_file)
+    return false;
+
+  _file = fopen(filename.c_str(), "wb");
+  if (!_file)
+    return false;
+
+  _seed = seed;
+  _configFile = configFile;
+  _numFrames = 0;
+
+  u32 len = (u32)configFile.size();
+  fwrite(INPUT_MAGIC, sizeof(INPUT_MAGIC), 1, _file);
+  fwrite(&seed, sizeof(seed), 1, _file);
+  fwrite(&len, sizeof(len), 1, _file);
+  fwrite(configFile.data(), 1, len, _file);
+  return !ferror(_file);
+}
+
+//----------------------------------------------------------------------------------
+bool InputLog::OpenRead(const string& filename)
+{
+  if (_file)
+    return false;
+
+  _file = fopen(filename.c_str(), "rb");
+  if (!_file)
+    return false;
+
+  char magic[sizeof(INPUT_MAGIC)];
+  u32 len = 0;
+  if (fread(magic, sizeof(magic), 1, _file) != 1
+      || memcmp(magic, INPUT_MAGIC, sizeof(magic)) != 0
+      || fread(&_seed, sizeof(_seed), 1, _file) != 1
+      || fread(&len, sizeof(len), 1, _file) != 1)
+  {
+    printf("%s isn't an input recording\n", filename.c_str());
+    Close();
+    return false;
+  }
+
+  _configFile.resize(len);
+  if (len && fread(&_configFile[0], 1, len, _file) != len)
+  {
+    Close();
+    return false;
+  }
+
+  _numFrames = 0;
+  return true;
+}
+
+//----------------------------------------------------------------------------------
+void InputLog::Close()
+{
+  if (_file)
+    fclose(_file);
+  _file = nullptr;
+}
+
+//----------------------------------------------------------------------------------
+bool InputLog::WriteFrame(const InputFrame& frame)
+{
+  if (!_file)
+    return false;
+
+  u8 numEvents = (u8)min<size_t>(frame.events.size(), MAX_EVENTS);
+  u8 flags = (frame.updated ? FLAG_UPDATED : 0) | numEvents;
+  fwrite(&flags, sizeof(flags), 1, _file);
+  if (numEvents)
+    fwrite(frame.events.data(), sizeof(InputEvent), numEvents, _file);
+
+  if (frame.updated)
+  {
+    fwrite(&frame.keys, sizeof(frame.keys), 1, _file);
+    fwrite(&frame.delta_us, sizeof(frame.delta_us), 1, _file);
+  }
+
+  ++_numFrames;
+  return !ferror(_file);
+}
+
+//----------------------------------------------------------------------------------
+bool InputLog::ReadFrame(InputFrame* frame)
+{
+  frame->Clear();
+  if (!_file)
+    return false;
+
+  u8 flags;
+  if (fread(&flags, sizeof(flags), 1, _file) != 1)
+    return false;
+
+  frame->events.resize(flags & MAX_EVENTS);
+  if (!frame->events.empty() && fread(frame->events.data(), sizeof(InputEvent), frame->events.size(), _file) != frame->events.size())
+    return false;
+
+  frame->updated = (flags & FLAG_UPDATED) != 0;
+  if (frame->updated)
+  {
+    if (fread(&frame->keys, sizeof(frame->keys), 1, _file) != 1
+        || fread(&frame->delta_us, sizeof(frame->delta_us), 1, _file) != 1)
+      return false;
+  }
+
+  ++_numFrames;
+  return true;
+}
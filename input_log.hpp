@@ -0,0 +1,59 @@
+#pragma once
+#include "types.hpp"
+
+namespace pang
+{
+  // The held keys HandleInput reads, as bits
+  struct InputKeys
+  {
+    enum Enum { Left = 0x1, Right = 0x2, Up = 0x4, Down = 0x8 };
+  };
+
+  // The key presses that change the simulation
+  enum class InputEvent : u8
+  {
+    Fire,
+    SpawnEnemies,
+    Quit,
+  };
+
+  // The input of one Game::Update. The events are applied first, then, if the simulation
+  // was updated, the keys and the delta
+  struct InputFrame
+  {
+    InputFrame() : updated(false), keys(0), delta_us(0) {}
+    void Clear() { updated = false; keys = 0; delta_us = 0; events.clear(); }
+
+    bool updated;
+    u8 keys;
+    u64 delta_us;
+    vector<InputEvent> events;
+  };
+
+  // A recorded session: the random seed and config it was started with, followed by the
+  // input of every update, so it can be replayed exactly
+  class InputLog
+  {
+  public:
+    InputLog();
+    ~InputLog();
+
+    bool OpenWrite(const string& filename, u32 seed, const string& configFile);
+    bool OpenRead(const string& filename);
+    void Close();
+
+    bool WriteFrame(const InputFrame& frame);
+    // false at the end of the log
+    bool ReadFrame(InputFrame* frame);
+
+    u32 Seed() const { return _seed; }
+    const string& ConfigFile() const { return _configFile; }
+    u32 NumFrames() const { return _numFrames; }
+
+  private:
+    FILE* _file;
+    u32 _seed;
+    string _configFile;
+    u32 _numFrames;
+  };
+}
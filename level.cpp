@@ -1,208 +1,52 @@
 #include "level.hpp"
-#include "protocol/game.pb.h"
+#include "generator.hpp"
+#include "trace.hpp"
+#include "level_stats.hpp"
 
 using namespace pang;
 using namespace bristol;
 
-//----------------------------------------------------------------------------------
-bool Level::Init(const config::Game& config)
-{
-  _width = config.width();
-  _height = config.height();
-
-  _data.resize(_width * _height);
-
-  if (!GenerateLevel())
-    return false;
-
-  CreateTexture();
-  CalcWallDistance();
-
-  return true;
-}
-
-struct Room;
-struct Partition
+namespace
 {
-  enum Location
-  {
-    North,
-    South,
-    East,
-    West,
-  };
+  // the generator marks walls as white
+  const u32 WALL_COLOR = Level::Rgba(255, 255, 255);
 
-  enum Corner
+  //----------------------------------------------------------------------------------
+  u64 CellHeatHash(u32 idx, u8 heat)
   {
-    TopLeft, TopRight, BottomLeft, BottomRight,
-  };
-
-  Partition(const sf::IntRect& bounds)
-      : _bounds(bounds)
-  {
-    memset(_rooms, 0, sizeof(_rooms));
-    memset(_partitions, 0, sizeof(_partitions));
+    // cold cells hash to 0, so a fresh level's hash is 0
+    return heat ? HashCombine(idx, heat) : 0;
   }
-
-  sf::IntRect _bounds;
-  Room* _rooms[4];
-  Partition* _partitions[4];
-};
-
-struct Room
-{
-  Room(u32 id) : _id(id) {}
-  u32 _id;
-  sf::IntRect _bounds;
-};
-
-//----------------------------------------------------------------------------------
-struct Generator
-{
-  ~Generator();
-  // level generator based on: http://www.moddb.com/games/frozen-synapse/news/frozen-synapse-procedural-level-generation
-  void Run(const pang::level::Level& config);
-  void RunInner(Partition* parent);
-  Room* CreateRoom(Partition* parent);
-
-  void AddPartition(Partition* parent, Partition::Location loc, const sf::IntRect& bounds);
-
-  pang::level::Level _config;
-  sf::IntRect _bounds;
-  vector<Room*> _rooms;
-  vector<Partition*> _partitions;
-};
-
-//----------------------------------------------------------------------------------
-Generator::~Generator()
-{
-  for (Room* r : _rooms)
-    delete r;
-
-  for (Partition* p : _partitions)
-    delete p;
 }
 
 //----------------------------------------------------------------------------------
-void Generator::Run(const pang::level::Level& config)
+bool Level::Init(u32 width, u32 height, const pang::level::Level& levelConfig)
 {
-  _config = config;
+  TRACE_SCOPE("Level::Init");
+  _width = width;
+  _height = height;
+  _levelConfig = levelConfig;
 
-  // the bounds are retracted to allow for a 1 pixel wall
-  _bounds = sf::IntRect(1, 1, config.width() - 3, config.height() - 3);
+  _data.assign(_width * _height, Cell());
+  _heatHash = 0;
 
-  // add the global partition
-  _partitions.push_back(new Partition(_bounds));
-  RunInner(_partitions.back());
-}
-
-//----------------------------------------------------------------------------------
-void Generator::RunInner(Partition* parent)
-{
-  if (/*_rooms.size() >= _config.num_rooms()*/ false
-      || parent->_bounds.width <= _config.min_room_width()
-      || parent->_bounds.height <= _config.min_room_height())
-  {
-    return;
-  }
-
-  _rooms.push_back(CreateRoom(parent));
-  for (int i = 0; i < 4; ++i)
-  {
-    if (Partition* p = parent->_partitions[i])
-    {
-      RunInner(p);
-    }
-  }
-}
-
-//----------------------------------------------------------------------------------
-void Generator::AddPartition(Partition* parent, Partition::Location loc, const sf::IntRect& bounds)
-{
-  Partition* p = new Partition(bounds);
-  _partitions.push_back(p);
-  parent->_partitions[loc] = p;
-}
+  if (!GenerateLevel())
+    return false;
 
-//----------------------------------------------------------------------------------
-Room* Generator::CreateRoom(Partition* parent)
-{
-  // create a room inside the given bounds
-  u32 id = _rooms.size();
-  Room* room = new Room(id);
-
-  int width = randf(_config.min_room_width(), min(_config.max_room_width(), parent->_bounds.width));
-  int height = randf(_config.min_room_height(), min(_config.max_room_height(), parent->_bounds.height));
-  room->_bounds.width = width;
-  room->_bounds.height = height;
-
-  // extract bounding dimensions
-  int bleft   = parent->_bounds.left;
-  int bright  = bleft + parent->_bounds.width;
-  int btop    = parent->_bounds.top;
-  int bbottom = btop + parent->_bounds.height;
-  int bwidth  = parent->_bounds.width;
-  int bheight = parent->_bounds.height;
-  int rwidth  = bwidth - width;
-  int rheight = bheight - height;
-
-  // choose starting corner
-  switch (rand() % 4)
-  {
-    // top left
-    case 0:
-      parent->_rooms[Partition::TopLeft] = room;
-      room->_bounds.top = btop;
-      room->_bounds.left = bleft;
-      AddPartition(parent, Partition::South, sf::IntRect(bleft, btop + height, width, rheight));
-      AddPartition(parent, Partition::East, sf::IntRect(bleft + width, btop, rwidth, bheight));
-      break;
-
-    // top right
-    case 1:
-      parent->_rooms[Partition::TopRight] = room;
-      room->_bounds.top = btop;
-      room->_bounds.left = bright - width + 1;
-      AddPartition(parent, Partition::West, sf::IntRect(bleft, btop, rwidth, bheight));
-      AddPartition(parent, Partition::South, sf::IntRect(bright - width, btop + height, width, rheight));
-      break;
-
-    // bottom left
-    case 2:
-      parent->_rooms[Partition::BottomLeft] = room;
-      room->_bounds.top = bbottom - height;
-      room->_bounds.left = bleft;
-      AddPartition(parent, Partition::North, sf::IntRect(bleft, btop, width, rheight));
-      AddPartition(parent, Partition::East, sf::IntRect(bleft + width, btop, rwidth, bheight));
-      break;
-
-    // bottom right
-    case 3:
-      parent->_rooms[Partition::BottomRight] = room;
-      room->_bounds.top = bbottom - height;
-      room->_bounds.left = bright - width;
-      AddPartition(parent, Partition::West, sf::IntRect(bleft, btop, rwidth, bheight));
-      AddPartition(parent, Partition::North, sf::IntRect(bright - width, btop, width, rheight));
-      break;
-  }
+  CalcTerrain();
+  CalcWallDistance();
 
-  return room;
+  return true;
 }
 
 //----------------------------------------------------------------------------------
 bool Level::GenerateLevel()
 {
-#ifdef WIN32
-  string base("d:/projects/pang/");
-#else
-  string base("/Users/dooz/projects/pang/");
-#endif
-
-  if (!LoadProto((base + "config/level1.pb").c_str(), &_levelConfig))
-    return false;
-
   Generator gen;
-  gen.Run(_levelConfig);
+  {
+    TRACE_SCOPE("Generator::Run");
+    gen.Run(_levelConfig);
+  }
 
 #if 0
   for (const Room* r : gen._rooms)
@@ -241,7 +85,7 @@ bool Level::GenerateLevel()
     int top     = r->_bounds.top;
     int bottom  = r->_bounds.top + r->_bounds.height;
 
-    Color col(rand() % 255, rand() % 255, rand() % 255);
+    u32 col = Rgba(rand() % 255, rand() % 255, rand() % 255);
     AddRect(left, top, right, bottom, col, r->_id);
   }
 
@@ -253,6 +97,8 @@ bool Level::GenerateLevel()
 //----------------------------------------------------------------------------------
 void Level::CalcAdjacency()
 {
+  TRACE_SCOPE("Level::CalcAdjacency");
+  _connections.clear();
   const auto& sortedPair = [](u32 a, u32 b) { return make_pair(min(a, b), max(a, b)); };
 
   for (int i = 0; i < (int)_height-1; ++i)
@@ -302,7 +148,7 @@ void Level::CalcAdjacency()
         if (x > 0 && x < (int)_width - 1 && (i == doorPos || i == doorPos + 1))
           continue;
 
-        _data[y*_width+x].col = Color::White;
+        _data[y*_width+x].col = WALL_COLOR;
       }
     }
     {
@@ -316,7 +162,7 @@ void Level::CalcAdjacency()
         if (y > 0 && y < (int)_height - 1 && (i == doorPos || i == doorPos + 1))
             continue;
 
-        _data[y*_width+x].col = Color::White;
+        _data[y*_width+x].col = WALL_COLOR;
       }
 
       // fill the corner
@@ -326,7 +172,7 @@ void Level::CalcAdjacency()
         int y = v[0].y;
         if (x > 0 && _data[y*_width+x-1].roomId == ~0)
         {
-          _data[y*_width+x-1].col = Color::White;
+          _data[y*_width+x-1].col = WALL_COLOR;
         }
       }
     }
@@ -336,7 +182,7 @@ void Level::CalcAdjacency()
 
 
 //----------------------------------------------------------------------------------
-void Level::AddRect(int x0, int y0, int x1, int y1, const Color& color, u32 roomId)
+void Level::AddRect(int x0, int y0, int x1, int y1, u32 color, u32 roomId)
 {
   for (int i = y0; i < y1; ++i)
   {
@@ -362,6 +208,8 @@ bool Level::IsVisible(u32 x0, u32 y0, u32 x1, u32 y1) const
   int sy = y0 < y1 ? 1 : -1;
 
   const Cell* ptr = &_data[x0 + y0 * _width];
+  bool visible = true;
+  LEVEL_STATS(u32 steps = 0);
 
   int sPtrY = sy * (int)_width;
 
@@ -371,8 +219,12 @@ bool Level::IsVisible(u32 x0, u32 y0, u32 x1, u32 y1) const
     int threshold = dx;
     while (true)
     {
+      LEVEL_STATS(++steps);
       if (ptr->terrain > 0)
-        return false;
+      {
+        visible = false;
+        break;
+      }
 
       if (x0 == x1)
         break;
@@ -394,8 +246,12 @@ bool Level::IsVisible(u32 x0, u32 y0, u32 x1, u32 y1) const
     int threshold = dy;
     while (true)
     {
+      LEVEL_STATS(++steps);
       if (ptr->terrain > 0)
-        return false;
+      {
+        visible = false;
+        break;
+      }
 
       if (y0 == y1)
         break;
@@ -411,7 +267,9 @@ bool Level::IsVisible(u32 x0, u32 y0, u32 x1, u32 y1) const
       ptr += sPtrY;
     }
   }
-  return true;
+
+  LEVEL_STATS(g_levelStats.AddVisible(steps, visible));
+  return visible;
 }
 
 //----------------------------------------------------------------------------------
@@ -424,6 +282,7 @@ bool Level::IsValidPos(const Tile& tile) const
 //----------------------------------------------------------------------------------
 bool Level::Idx(u32 x, u32 y, const function<void(u32)>& fn) const
 {
+  LEVEL_STATS(g_levelStats.AddIdx());
   if (x >= _width || y >= _height)
     return false;
   fn(y * _width + x);
@@ -433,6 +292,7 @@ bool Level::Idx(u32 x, u32 y, const function<void(u32)>& fn) const
 //----------------------------------------------------------------------------------
 bool Level::Idx(u32 x, u32 y, u32* idx) const
 {
+  LEVEL_STATS(g_levelStats.AddIdx());
   if (x >= _width || y >= _height)
     return false;
 
@@ -453,27 +313,37 @@ bool Level::GetTerrain(u32 x, u32 y, u8* v) const
 }
 
 //----------------------------------------------------------------------------------
-bool Level::SetEntity(const Tile& tile, u16 entityId)
+bool Level::SetEntity(const Tile& tile, EntityId entityId)
 {
   return Idx(tile.x, tile.y, [=](u32 idx) { _data[idx].entityId = entityId; });
 }
 
 //----------------------------------------------------------------------------------
-bool Level::SetEntity(u32 x, u32 y, u16 entityId)
+bool Level::SetEntity(u32 x, u32 y, EntityId entityId)
 {
   return Idx(x, y, [=](u32 idx) { _data[idx].entityId = entityId; });
 }
 
 //----------------------------------------------------------------------------------
-bool Level::GetEntity(const Tile& tile, u16* entityId) const
+bool Level::GetEntity(const Tile& tile, EntityId* entityId) const
 {
-  return Idx(tile.x, tile.y, [=](u32 idx) { *entityId = _data[idx].terrain; });
+  return Idx(tile.x, tile.y, [=](u32 idx) { *entityId = _data[idx].entityId; });
 }
 
 //----------------------------------------------------------------------------------
-bool Level::GetEntity(u32 x, u32 y, u16* entityId) const
+void Level::ClearEntity(const Tile& tile, EntityId entityId)
 {
-  return Idx(x, y, [=](u32 idx) { *entityId = _data[idx].terrain; });
+  Idx(tile.x, tile.y, [=](u32 idx)
+  {
+    if (_data[idx].entityId == entityId)
+      _data[idx].entityId = NO_ENTITY;
+  });
+}
+
+//----------------------------------------------------------------------------------
+bool Level::GetEntity(u32 x, u32 y, EntityId* entityId) const
+{
+  return Idx(x, y, [=](u32 idx) { *entityId = _data[idx].entityId; });
 }
 
 //----------------------------------------------------------------------------------
@@ -487,56 +357,79 @@ void Level::GetSize(u32* width, u32* height) const
 }
 
 //----------------------------------------------------------------------------------
-const Texture& Level::GetTexture() const
+bool Level::GetCell(const Tile& tile, Cell** cell)
 {
-  return _texture;
+  // indexes directly rather than through Idx, so each access is only counted once
+  LEVEL_STATS(g_levelStats.AddGetCell());
+  if (tile.x >= _width || tile.y >= _height)
+    return false;
+
+  *cell = &_data[tile.y * _width + tile.x];
+  return true;
 }
 
+
 //----------------------------------------------------------------------------------
-bool Level::GetCell(const Tile& tile, Cell** cell)
+bool Level::SetHeat(const Tile& tile, u8 heat)
 {
-  return Idx(tile.x, tile.y, [=](u32 idx) { *cell = &_data[idx]; });
+  return Idx(tile.x, tile.y, [=](u32 idx) {
+    Cell& cell = _data[idx];
+    _heatHash += CellHeatHash(idx, heat) - CellHeatHash(idx, cell.heat);
+    cell.heat = heat;
+  });
 }
 
+//----------------------------------------------------------------------------------
+void Level::CalcTerrain()
+{
+  for (Cell& cell : _data)
+  {
+    cell.terrain = cell.col == WALL_COLOR ? 1 : 0;
+  }
+}
 
 //----------------------------------------------------------------------------------
-void Level::CreateTexture()
+void Level::GetTerrainAndHeat(u8* terrain, u8* heat) const
 {
-  _texture.create(_width, _height);
+  for (const Cell& cell : _data)
+  {
+    *terrain++ = cell.terrain;
+    *heat++ = cell.heat;
+  }
+}
 
-  // create rgba texture
-  vector<Color> pixels(_width * _height);
-  Color* p = pixels.data();
+//----------------------------------------------------------------------------------
+void Level::GetPixels(vector<u32>* pixels) const
+{
+  pixels->resize(_width * _height);
+  u32* p = pixels->data();
 
 
   for (u32 i = 0; i < _height; ++i)
   {
     for (u32 j = 0; j < _width; ++j)
     {
-      Cell& cell = _data[i*_width+j];
-      cell.terrain = cell.col == Color::White ? 1 : 0;
+      const Cell& cell = _data[i*_width+j];
       *p++ = cell.col;
 #if 0
-      if (cell.terrain > 0)
+      if (cell.terrain != 0)
       {
-        *p++ = Color::White;
+        *p++ = WALL_COLOR;
       }
       else
       {
-        *p++ = Color(max(0, 255 - 10 * cell.GetWallDistW()), 0, 0);
+        *p++ = Rgba(max(0, 255 - 10 * cell.GetWallDistW()), 0, 0);
       }
 #endif
     }
   }
-
-  _texture.update((const u8*)pixels.data());
 }
 
 //----------------------------------------------------------------------------------
-void Level::UpdateTexture()
+void Level::UpdateHeat(vector<u32>* pixels)
 {
-  vector<Color> pixels(_width * _height);
-  Color* p = pixels.data();
+  pixels->resize(_width * _height);
+  u32* p = pixels->data();
   Cell* cell = _data.data();
   for (u32 i = 0; i < _height; ++i)
   {
@@ -545,30 +438,30 @@ void Level::UpdateTexture()
       if (cell->terrain == 0)
       {
         u8 h = cell->newHeat;
+        u32 idx = (u32)(cell - _data.data());
+        _heatHash += CellHeatHash(idx, h) - CellHeatHash(idx, cell->heat);
         cell->heat = cell->newHeat;
-        *p = Color(h, h, h, 255);
+        *p = Rgba(h, h, h, 255);
       }
       else
       {
-        *p = Color::White;
+        *p = WALL_COLOR;
       }
 
       ++cell;
       ++p;
     }
   }
-
-  _texture.update((const u8*)pixels.data());
 }
 
 
 //----------------------------------------------------------------------------------
 void Level::Diffuse()
 {
-  // box filter all the cell heat
-  Cell* cell = _data.data();
+  // box filter all the cell heat, skipping the border cells
   for (u32 i = 1; i < _height-1; ++i)
   {
+    Cell* cell = &_data[i*_width+1];
     for (u32 j = 1; j < _width-1; ++j)
     {
       static s32 ofs[] = {
@@ -591,36 +484,47 @@ void Level::Diffuse()
 //----------------------------------------------------------------------------------
 void Level::CalcWallDistance()
 {
-  for (u32 i = 0; i < _height; ++i)
+  TRACE_SCOPE("Level::CalcWallDistance");
+
+  // the distance to the closest wall (or level edge) in each direction. this is done
+  // with a sweep down and to the east, and a sweep up and to the west, keeping track of
+  // the last wall seen in each row and column
+  vector<int> wallN(_width, -1);
+  for (int i = 0; i < (int)_height; ++i)
   {
-    for (u32 j = 0; j < _width; ++j)
+    int wallW = -1;
+    for (int j = 0; j < (int)_width; ++j)
     {
       Cell& cell = _data[i*_width+j];
       cell.wallDist = 0;
-      if (cell.terrain == 0)
+      if (cell.terrain != 0)
       {
-        int k;
-
-        // N
-        for (k = i - 1; k >= 0 && _data[k*_width+j].terrain == 0; --k)
-          continue;
-        cell.wallDist |= (u64)(i - max(0, k)) << 48;
-
-        // S
-        for (k = i + 1; k < (int)_height && _data[k*_width+j].terrain == 0; ++k)
-          continue;
-        cell.wallDist |= (u64)(min((int)_height-1, k) - i) << 32;
+        wallN[j] = i;
+        wallW = j;
+        continue;
+      }
 
-        // W
-        for (k = j - 1; k >= 0 && _data[i*_width+k].terrain == 0; --k)
-          continue;
-        cell.wallDist |= (u64)(j - max(0, k)) << 16;
+      cell.wallDist |= (u64)(i - max(0, wallN[j])) << 48;
+      cell.wallDist |= (u64)(j - max(0, wallW)) << 16;
+    }
+  }
 
-        // E
-        for (k = j + 1; k < (int)_width && _data[i*_width+k].terrain == 0; ++k)
-          continue;
-        cell.wallDist |= (u64)(min((int)_width-1, k) - j) << 0;
+  vector<int> wallS(_width, _height);
+  for (int i = (int)_height - 1; i >= 0; --i)
+  {
+    int wallE = _width;
+    for (int j = (int)_width - 1; j >= 0; --j)
+    {
+      Cell& cell = _data[i*_width+j];
+      if (cell.terrain != 0)
+      {
+        wallS[j] = i;
+        wallE = j;
+        continue;
       }
+
+      cell.wallDist |= (u64)(min((int)_height-1, wallS[j]) - i) << 32;
+      cell.wallDist |= (u64)(min((int)_width-1, wallE) - j) << 0;
     }
   }
 }
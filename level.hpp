@@ -5,19 +5,14 @@
 
 namespace pang
 {
-  namespace config
-  {
-    class Game;
-  }
-
   struct Level
   {
     struct Cell
     {
       u64 wallDist; // 16 bits for N, S, W, E
-      Color col;
+      u32 col;      // rgba, see Rgba()
       u32 roomId;
-      u16 entityId;
+      EntityId entityId;
       u8 terrain;
       u8 heat;
       u8 newHeat;
@@ -28,40 +23,57 @@ namespace pang
       u16 GetWallDistE() const { return (wallDist >>  0) & 0xffff; }
     };
 
-    Level() : _width(0), _height(0) {}
+    Level() : _width(0), _height(0), _heatHash(0) {}
+
+    // packs a color in the byte order expected by sf::Texture::update
+    static u32 Rgba(u8 r, u8 g, u8 b, u8 a = 255) { return r | (g << 8) | (b << 16) | ((u32)a << 24); }
 
     bool IsVisible(u32 x0, u32 y0, u32 x1, u32 y1) const;
     bool IsValidPos(const Tile& tile) const;
-    bool Init(const config::Game& config);
+    bool Init(u32 width, u32 height, const pang::level::Level& levelConfig);
 
-    bool SetEntity(const Tile& tile, u16 entityId);
-    bool GetEntity(const Tile& tile, u16* entityId) const;
-    void CreateTexture();
-    void UpdateTexture();
+    // the cells hold the last entity to move into them
+    bool SetEntity(const Tile& tile, EntityId entityId);
+    bool GetEntity(const Tile& tile, EntityId* entityId) const;
+    // clears the cell's entity, if it's entityId
+    void ClearEntity(const Tile& tile, EntityId entityId);
+    // writes the cell colors as rgba pixels
+    void GetPixels(vector<u32>* pixels) const;
+    // writes the terrain and heat of each cell, row major, width * height bytes each
+    void GetTerrainAndHeat(u8* terrain, u8* heat) const;
+    // the heat must be changed through SetHeat or UpdateHeat to keep HeatHash current
+    bool SetHeat(const Tile& tile, u8 heat);
+    u64 HeatHash() const { return _heatHash; }
+    // commits the diffused heat, and writes it as grayscale pixels
+    void UpdateHeat(vector<u32>* pixels);
     void Diffuse();
 
     void GetSize(u32* width, u32* height) const;
-    const Texture& GetTexture() const;
 
     bool GetCell(const Tile& tile, Cell** cell);
 
   private:
+    // the benchmarks time the private kernels directly
+    friend struct LevelBench;
+
     struct Walls { vector<Vector2i> horiz; vector<Vector2i> vert; };
     map<pair<u32, u32>, Walls> _connections;
     void CalcAdjacency();
-    void AddRect(int x0, int y0, int x1, int y1, const Color& color, u32 roomId);
+    void AddRect(int x0, int y0, int x1, int y1, u32 color, u32 roomId);
     bool GenerateLevel();
+    void CalcTerrain();
     bool SetTerrain(u32 x, u32 y, u8 v);
     bool GetTerrain(u32 x, u32 y, u8* v) const;
-    bool SetEntity(u32 x, u32 y, u16 entityId);
-    bool GetEntity(u32 x, u32 y, u16* entityId) const;
+    bool SetEntity(u32 x, u32 y, EntityId entityId);
+    bool GetEntity(u32 x, u32 y, EntityId* entityId) const;
     bool Idx(u32 x, u32 y, u32* idx) const;
     bool Idx(u32 x, u32 y, const function<void(u32)>& fn) const;
     void CalcWallDistance();
 
-    Texture _texture;
     u32 _width, _height;
     vector<Cell> _data;
+    // sum of the hashes of the cells with heat, so a change updates it in constant time
+    u64 _heatHash;
     pang::level::Level _levelConfig;
 
   };
@@ -0,0 +1,127 @@
+#include "level_stats.hpp"
+
+#ifdef PANG_LEVEL_STATS
+
+using namespace pang;
+
+namespace pang
+{
+  LevelStats g_levelStats;
+}
+
+//----------------------------------------------------------------------------------
+const char* pang::LevelCallerName(LevelCaller caller)
+{
+  switch (caller)
+  {
+    case LevelCaller::Other: return "Other";
+    case LevelCaller::Visibility: return "Visibility";
+    case LevelCaller::Physics: return "Physics";
+    case LevelCaller::AvoidWall: return "AvoidWall";
+    case LevelCaller::Bullets: return "Bullets";
+    case LevelCaller::Spawn: return "Spawn";
+    default: return "Unknown";
+  }
+}
+
+//----------------------------------------------------------------------------------
+LevelStats::LevelStats()
+    : _caller(LevelCaller::Other)
+{
+  Reset();
+}
+
+//----------------------------------------------------------------------------------
+void LevelStats::Reset()
+{
+  memset(_frame, 0, sizeof(_frame));
+  memset(_total, 0, sizeof(_total));
+  memset(_max, 0, sizeof(_max));
+  memset(_steps, 0, sizeof(_steps));
+  memset(_totalSteps, 0, sizeof(_totalSteps));
+  _numFrames = 0;
+}
+
+//----------------------------------------------------------------------------------
+void LevelStats::AddVisible(u32 steps, bool visible)
+{
+  int caller = (int)_caller;
+  _frame[caller].visible++;
+  if (!visible)
+    _frame[caller].blocked++;
+
+  // bucket i holds lines of [2^(i-1), 2^i) cells
+  u32 bucket = 0;
+  while (steps >> bucket && bucket < NUM_STEP_BUCKETS - 1)
+    ++bucket;
+  _steps[caller][bucket]++;
+  _totalSteps[caller] += steps;
+}
+
+//----------------------------------------------------------------------------------
+void LevelStats::EndFrame()
+{
+  for (int i = 0; i < NUM_CALLERS; ++i)
+  {
+    Counts& f = _frame[i];
+    Counts& t = _total[i];
+    Counts& m = _max[i];
+    t.visible += f.visible;
+    t.blocked += f.blocked;
+    t.getCell += f.getCell;
+    t.idx += f.idx;
+    m.visible = max(m.visible, f.visible);
+    m.blocked = max(m.blocked, f.blocked);
+    m.getCell = max(m.getCell, f.getCell);
+    m.idx = max(m.idx, f.idx);
+  }
+
+  memset(_frame, 0, sizeof(_frame));
+  ++_numFrames;
+}
+
+//----------------------------------------------------------------------------------
+void LevelStats::PrintSummary() const
+{
+  if (_numFrames == 0)
+    return;
+
+  printf("level queries per frame (avg / max):\n");
+  printf("%-12s %20s %20s %20s %20s\n", "caller", "IsVisible", "blocked", "GetCell", "Idx");
+  double scale = 1.0 / _numFrames;
+  for (int i = 0; i < NUM_CALLERS; ++i)
+  {
+    const Counts& t = _total[i];
+    const Counts& m = _max[i];
+    if (!t.visible && !t.getCell && !t.idx)
+      continue;
+
+    printf("%-12s %11.1f / %6llu %11.1f / %6llu %11.1f / %6llu %11.1f / %6llu\n", LevelCallerName((LevelCaller)i),
+        t.visible * scale, (unsigned long long)m.visible, t.blocked * scale, (unsigned long long)m.blocked,
+        t.getCell * scale, (unsigned long long)m.getCell, t.idx * scale, (unsigned long long)m.idx);
+  }
+
+  for (int i = 0; i < NUM_CALLERS; ++i)
+  {
+    if (!_total[i].visible)
+      continue;
+
+    printf("IsVisible cells walked (%s), avg %.1f:", LevelCallerName((LevelCaller)i),
+        (double)_totalSteps[i] / _total[i].visible);
+    for (int j = 0; j < NUM_STEP_BUCKETS; ++j)
+    {
+      if (!_steps[i][j])
+        continue;
+
+      u32 lo = j == 0 ? 0 : 1 << (j - 1);
+      u32 hi = (1 << j) - 1;
+      if (j == NUM_STEP_BUCKETS - 1)
+        printf(" %u+: %llu", lo, (unsigned long long)_steps[i][j]);
+      else
+        printf(" %u-%u: %llu", lo, hi, (unsigned long long)_steps[i][j]);
+    }
+    printf("\n");
+  }
+}
+
+#endif
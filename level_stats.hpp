@@ -0,0 +1,76 @@
+#pragma once
+#include "types.hpp"
+#include "trace.hpp"
+
+// the level query stats are only compiled in when PANG_LEVEL_STATS is defined (the cmake
+// option of the same name), and compile out completely otherwise
+
+namespace pang
+{
+  // the simulation stage making a level query
+  enum class LevelCaller
+  {
+    Other,
+    Visibility,
+    Physics,
+    AvoidWall,
+    Bullets,
+    Spawn,
+    CallerCount,
+  };
+
+#ifdef PANG_LEVEL_STATS
+  const char* LevelCallerName(LevelCaller caller);
+
+  // Counts Level::IsVisible, GetCell and Idx calls per frame, split by the caller set with
+  // LEVEL_CALLER, along with how many lines were blocked and a log2 histogram of the
+  // number of cells each line walked
+  struct LevelStats
+  {
+    enum { NUM_CALLERS = (int)LevelCaller::CallerCount, NUM_STEP_BUCKETS = 20 };
+
+    LevelStats();
+    void Reset();
+
+    void AddVisible(u32 steps, bool visible);
+    void AddGetCell() { _frame[(int)_caller].getCell++; }
+    void AddIdx() { _frame[(int)_caller].idx++; }
+
+    void EndFrame();
+    void PrintSummary() const;
+
+    LevelCaller _caller;
+
+  private:
+    struct Counts
+    {
+      u64 visible;
+      u64 blocked;
+      u64 getCell;
+      u64 idx;
+    };
+
+    Counts _frame[NUM_CALLERS];
+    Counts _total[NUM_CALLERS];
+    Counts _max[NUM_CALLERS];
+    u64 _steps[NUM_CALLERS][NUM_STEP_BUCKETS];
+    u64 _totalSteps[NUM_CALLERS];
+    u32 _numFrames;
+  };
+
+  extern LevelStats g_levelStats;
+
+  struct ScopedLevelCaller
+  {
+    ScopedLevelCaller(LevelCaller caller) : _prev(g_levelStats._caller) { g_levelStats._caller = caller; }
+    ~ScopedLevelCaller() { g_levelStats._caller = _prev; }
+    LevelCaller _prev;
+  };
+
+#define LEVEL_STATS(x) x
+#define LEVEL_CALLER(caller) pang::ScopedLevelCaller PROFILE_CONCAT(levelCaller, __LINE__)(pang::LevelCaller::caller)
+#else
+#define LEVEL_STATS(x)
+#define LEVEL_CALLER(caller)
+#endif
+}
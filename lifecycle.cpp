@@ -0,0 +1,55 @@
+#include "lifecycle.hpp"
+#include "entity.hpp"
+
+using namespace pang;
+
+//----------------------------------------------------------------------------------
+EntityLifecycle::EntityLifecycle(EntityStore* entities)
+    : _entities(entities)
+    , _numDestroyed(0)
+{
+}
+
+//----------------------------------------------------------------------------------
+void EntityLifecycle::AddCleanupHook(const CleanupHook& hook)
+{
+  _hooks.push_back(hook);
+}
+
+//----------------------------------------------------------------------------------
+void EntityLifecycle::Destroy(EntityId id)
+{
+  u32 slot;
+  if (!_entities->Find(id, &slot) || IsDestroyed(slot))
+    return;
+
+  if (slot >= _destroyed.size())
+    _destroyed.resize(max<size_t>(_entities->Size(), 2 * _destroyed.size()));
+
+  _destroyed[slot] = 1;
+  _pending.push_back(slot);
+}
+
+//----------------------------------------------------------------------------------
+u32 EntityLifecycle::Flush()
+{
+  if (_pending.empty())
+    return 0;
+
+  // hooks run in slot order, so the cleanup doesn't depend on the order of the kills
+  sort(_pending.begin(), _pending.end());
+  for (u32 slot : _pending)
+  {
+    EntityId id = _entities->_id[slot];
+    for (const CleanupHook& hook : _hooks)
+      hook(id, slot);
+    _destroyed[slot] = 0;
+  }
+
+  _entities->Remove(_pending);
+
+  u32 numRemoved = (u32)_pending.size();
+  _numDestroyed += numRemoved;
+  _pending.clear();
+  return numRemoved;
+}
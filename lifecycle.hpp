@@ -0,0 +1,41 @@
+#pragma once
+#include "types.hpp"
+
+namespace pang
+{
+  class EntityStore;
+
+  // Deferred entity destruction. A destroyed entity stays in the store, and keeps its slot,
+  // until Flush, so the systems can destroy entities while they walk the slots. Flush runs
+  // the cleanup hooks of the subsystems with per entity side state, then removes every
+  // destroyed entity in a single compaction pass
+  class EntityLifecycle
+  {
+  public:
+    // called with the entity's id and slot, before the entity is removed
+    typedef function<void(EntityId id, u32 slot)> CleanupHook;
+
+    EntityLifecycle(EntityStore* entities);
+
+    void AddCleanupHook(const CleanupHook& hook);
+
+    // destroying an entity twice, or one that's already gone, does nothing
+    void Destroy(EntityId id);
+    bool IsDestroyed(u32 slot) const { return slot < _destroyed.size() && _destroyed[slot]; }
+
+    // runs the cleanup hooks, and removes the destroyed entities. returns the number removed
+    u32 Flush();
+
+    u32 NumPending() const { return (u32)_pending.size(); }
+    u64 NumDestroyed() const { return _numDestroyed; }
+
+  private:
+    EntityStore* _entities;
+    vector<CleanupHook> _hooks;
+
+    // slots of the destroyed entities, and a flag per slot
+    vector<u32> _pending;
+    vector<u8> _destroyed;
+    u64 _numDestroyed;
+  };
+}
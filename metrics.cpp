@@ -0,0 +1,138 @@
+#include "metrics.hpp"
+
+using namespace pang;
+
+namespace pang
+{
+  MetricsRegistry g_metrics;
+}
+
+namespace
+{
+  struct MetricInfo
+  {
+    const char* name;
+    const char* type;
+    const char* help;
+  };
+
+  const MetricInfo METRIC_INFO[] =
+  {
+    { "entities", "gauge", "Live entities" },
+    { "dead_entities_total", "counter", "Entities destroyed, by bullets or directly" },
+    { "bullets", "gauge", "Bullets in flight" },
+    { "updates_total", "counter", "Simulation updates" },
+    { "physics_ticks_total", "counter", "Fixed step physics ticks" },
+    { "physics_substeps", "gauge", "Physics ticks taken in the last update" },
+    { "coordinator_messages_total", "counter", "Ai messages handled by the coordinator" },
+    { "coordinator_messages", "gauge", "Ai messages handled in the last update" },
+    { "los_checks_total", "counter", "Line of sight checks" },
+    { "wander_states", "gauge", "Entities with wander state" },
+    { "messages", "gauge", "On screen messages" },
+  };
+
+  static_assert(sizeof(METRIC_INFO) / sizeof(METRIC_INFO[0]) == (int)Metric::MetricCount, "missing metric info");
+}
+
+//----------------------------------------------------------------------------------
+MetricsRegistry::MetricsRegistry()
+    : _intervalMs(0)
+    , _prometheus(false)
+    , _startNs(0)
+    , _done(false)
+{
+  for (int i = 0; i < NUM_METRICS; ++i)
+    _values[i] = 0;
+}
+
+//----------------------------------------------------------------------------------
+MetricsRegistry::~MetricsRegistry()
+{
+  Stop();
+}
+
+//----------------------------------------------------------------------------------
+bool MetricsRegistry::Start(const string& filename, u32 intervalMs)
+{
+  if (_thread.joinable() || intervalMs == 0)
+    return false;
+
+  _filename = filename;
+  _intervalMs = intervalMs;
+  const string ext(".prom");
+  _prometheus = filename.size() >= ext.size() && filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+  _startNs = NowNs();
+  _done = false;
+
+  // check up front that the snapshot can be written
+  if (!WriteSnapshot())
+    return false;
+
+  _thread = thread(&MetricsRegistry::WriterThread, this);
+  return true;
+}
+
+//----------------------------------------------------------------------------------
+void MetricsRegistry::Stop()
+{
+  if (!_thread.joinable())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _done = true;
+  }
+  _cv.notify_one();
+  _thread.join();
+}
+
+//----------------------------------------------------------------------------------
+void MetricsRegistry::WriterThread()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (!_done)
+  {
+    _cv.wait_for(lock, std::chrono::milliseconds(_intervalMs));
+    WriteSnapshot();
+  }
+}
+
+//----------------------------------------------------------------------------------
+bool MetricsRegistry::WriteSnapshot()
+{
+  // write to a temp file, and rename it over the snapshot
+  string tmp = _filename + ".tmp";
+  FILE* f = fopen(tmp.c_str(), "w");
+  if (!f)
+    return false;
+
+  double uptime = (NowNs() - _startNs) / 1e9;
+  if (_prometheus)
+  {
+    fprintf(f, "# HELP pang_uptime_seconds Time since the metrics were started\n");
+    fprintf(f, "# TYPE pang_uptime_seconds gauge\n");
+    fprintf(f, "pang_uptime_seconds %.3f\n", uptime);
+    for (int i = 0; i < NUM_METRICS; ++i)
+    {
+      const MetricInfo& info = METRIC_INFO[i];
+      fprintf(f, "# HELP pang_%s %s\n", info.name, info.help);
+      fprintf(f, "# TYPE pang_%s %s\n", info.name, info.type);
+      fprintf(f, "pang_%s %llu\n", info.name, (unsigned long long)Get((Metric)i));
+    }
+  }
+  else
+  {
+    fprintf(f, "{\"uptime_seconds\":%.3f", uptime);
+    for (int i = 0; i < NUM_METRICS; ++i)
+      fprintf(f, ",\"%s\":%llu", METRIC_INFO[i].name, (unsigned long long)Get((Metric)i));
+    fprintf(f, "}\n");
+  }
+
+  fclose(f);
+
+#ifdef WIN32
+  // rename doesn't replace existing files on windows
+  remove(_filename.c_str());
+#endif
+  return rename(tmp.c_str(), _filename.c_str()) == 0;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "types.hpp"
+
+namespace pang
+{
+  enum class Metric
+  {
+    Entities,
+    DeadEntitiesTotal,
+    Bullets,
+    Updates,
+    PhysicsTicks,
+    PhysicsSubsteps,
+    CoordinatorMessagesTotal,
+    CoordinatorMessages,
+    LosChecks,
+    WanderStates,
+    Messages,
+    MetricCount,
+  };
+
+  // Counters and gauges for long running (soak) runs. These are updated from the game
+  // thread with relaxed atomics, and a writer thread periodically snapshots them to a file,
+  // as Prometheus text format if the filename ends in ".prom", and json otherwise. The file
+  // is replaced atomically, so a collector never reads a partial snapshot
+  struct MetricsRegistry
+  {
+    enum { NUM_METRICS = (int)Metric::MetricCount };
+
+    MetricsRegistry();
+    ~MetricsRegistry();
+
+    bool Start(const string& filename, u32 intervalMs);
+    // writes a final snapshot, and stops the writer thread
+    void Stop();
+
+    void Set(Metric metric, u64 value) { _values[(int)metric].store(value, std::memory_order_relaxed); }
+    void Add(Metric metric, u64 value) { _values[(int)metric].fetch_add(value, std::memory_order_relaxed); }
+    u64 Get(Metric metric) const { return _values[(int)metric].load(std::memory_order_relaxed); }
+
+  private:
+    void WriterThread();
+    bool WriteSnapshot();
+
+    atomic<u64> _values[NUM_METRICS];
+
+    string _filename;
+    u32 _intervalMs;
+    bool _prometheus;
+    u64 _startNs;
+
+    thread _thread;
+    std::mutex _mutex;
+    condition_variable _cv;
+    bool _done;
+  };
+
+  extern MetricsRegistry g_metrics;
+}
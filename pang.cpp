@@ -1,214 +1,338 @@
 #include "pang.hpp"
 #include "behavior.hpp"
+#include "profiler.hpp"
+#include "metrics.hpp"
+#include "level_stats.hpp"
+#include "sampler.hpp"
+#include "flight_recorder.hpp"
+#include "snapshot.hpp"
+#include "checksum.hpp"
 
 using namespace pang;
 using namespace bristol;
 
+namespace
+{
+  // number of squads and behaviors shown in the cost overlay and summary
+  const u32 NUM_TOP_COSTS = 5;
+  // debug lines are dropped when nothing new has been logged for this many frames
+  const u32 DEBUG_LINE_FRAMES = 10;
+
+  //----------------------------------------------------------------------------------
+  int RunViewer(const string& name)
+  {
+    SnapshotReader reader;
+    if (!reader.Open(name))
+    {
+      printf("unable to open the snapshot %s\n", name.c_str());
+      return 1;
+    }
+
+    const SnapshotHeader& header = reader.Header();
+    u32 w = header.width;
+    u32 h = header.height;
+    float g = (float)header.gridSize;
+    Vector2f ofs(g/2, g/2);
+
+    // the level is only published once, so its texture is made up front
+    vector<u32> pixels(w * h);
+    const u8* terrain = reader.Terrain();
+    for (u32 i = 0; i < w * h; ++i)
+      pixels[i] = terrain[i] ? Level::Rgba(0x60, 0x60, 0x60) : Level::Rgba(0x20, 0x20, 0x20);
+
+    Texture levelTexture;
+    levelTexture.create(w, h);
+    levelTexture.update((const u8*)pixels.data());
+    Sprite levelSprite;
+    levelSprite.setTexture(levelTexture);
+    levelSprite.setScale(g, g);
+
+    RenderWindow window(sf::VideoMode(1280, 800), "pang viewer");
+    window.setVerticalSyncEnabled(true);
+    View view;
+    view.setSize(Vector2f(1280, 800));
+    VertexArray triangles(sf::Triangles);
+    VertexArray quads(sf::Quads);
+
+    while (window.isOpen())
+    {
+      Event event;
+      while (window.pollEvent(event))
+      {
+        if (event.type == Event::Closed || (event.type == Event::KeyPressed && event.key.code == Keyboard::Escape))
+          window.close();
+      }
+
+      // the vertices are built straight from the shared frame, and thrown away if the
+      // publisher got to the frame in the meantime
+      u32 seq;
+      const SnapshotFrame* frame = reader.Acquire(&seq);
+      if (!frame)
+        continue;
+
+      triangles.clear();
+      quads.clear();
+      const SnapshotEntity* entities = reader.Entities(frame);
+      for (u32 i = 0; i < frame->numEntities; ++i)
+      {
+        const SnapshotEntity& e = entities[i];
+        Vector2f pos = ofs + Vector2f(e.x, e.y);
+        Transform rotation;
+        rotation.rotate(180 * e.rot / PI);
+        Color col = e.id == frame->localPlayerId ? Color::Green : Color::Yellow;
+        triangles.append(Vertex(pos + rotation.transformPoint(Vector2f(0, -g/2)), Color::Red));
+        triangles.append(Vertex(pos + rotation.transformPoint(Vector2f(-5, 0.75f * g/2)), col));
+        triangles.append(Vertex(pos + rotation.transformPoint(Vector2f(5, 0.75f * g/2)), col));
+        if (e.id == frame->localPlayerId)
+          view.setCenter(pos);
+      }
+
+      const SnapshotBullet* bullets = reader.Bullets(frame);
+      for (u32 i = 0; i < frame->numBullets; ++i)
+      {
+        Vector2f pos = ofs + Vector2f(bullets[i].x, bullets[i].y);
+        quads.append(Vertex(pos + Vector2f(-2, -2), Color::White));
+        quads.append(Vertex(pos + Vector2f(2, -2), Color::White));
+        quads.append(Vertex(pos + Vector2f(2, 2), Color::White));
+        quads.append(Vertex(pos + Vector2f(-2, 2), Color::White));
+      }
+
+      if (!reader.Validate(frame, seq))
+        continue;
+
+      window.clear();
+      window.setView(view);
+      window.draw(levelSprite);
+      window.draw(triangles);
+      window.draw(quads);
+      window.display();
+    }
+
+    return 0;
+  }
+}
+
+//----------------------------------------------------------------------------------
+GameSettings::GameSettings()
+    : headless(false)
+    , numTicks(0)
+    , traceFile("pang_trace.json")
+    , traceFrames(300)
+    , traceOnStart(false)
+    , hitchBudgetMs(1000.0f / 30)
+    , allocCheck(false)
+    , allocCheckFatal(false)
+    , allocWarmupFrames(0)
+    , metricsIntervalMs(1000)
+    , sampleHz(1000)
+    , perfCounters(false)
+    , flightSeconds(30)
+    , flightBufferMb(64)
+    , seed(1)
+    , checksumEntityInterval(0)
+{
+}
+
 //----------------------------------------------------------------------------------
 Game::Game()
-    : _gridSize(25)
+    : _selectedEntity(NO_ENTITY)
+    , _debugFrame(0)
     , _focus(true)
     , _done(false)
-    , _playerDead(false)
-    , _pausedEnemies(false)
-    , _localPlayerId(1)
+    , _clock(&_steadyClock)
+    , _lastUpdate(0)
     , _prevLeft(0)
     , _prevRight(0)
-    , _tickAcc(0)
+    , _recording(false)
+    , _replaying(false)
 {
   //_debugDraw.Set(DebugDrawFlags::DrawLevel);
 }
 
 //----------------------------------------------------------------------------------
-bool Game::Init()
+bool Game::Init(const GameSettings& settings)
 {
-  size_t width, height;
-#ifdef _WIN32
-  width = GetSystemMetrics(SM_CXFULLSCREEN);
-  height = GetSystemMetrics(SM_CYFULLSCREEN);
-#else
-  auto displayId = CGMainDisplayID();
-  width = CGDisplayPixelsWide(displayId);
-  height = CGDisplayPixelsHigh(displayId);
-#endif
-
-  sf::ContextSettings settings;
-  _windowSize = Vector2i(8 * width / 10, 8 * height / 10);
-  _renderWindow.reset(new RenderWindow(sf::VideoMode(_windowSize.x, _windowSize.y), "...", sf::Style::Default, settings));
-  _renderWindow->setVerticalSyncEnabled(true);
-  _eventManager.reset(new WindowEventManager(_renderWindow.get()));
+  _settings = settings;
 
-  _eventManager->RegisterHandler(Event::KeyPressed, bind(&Game::OnKeyPressed, this, _1));
-  _eventManager->RegisterHandler(Event::KeyReleased, bind(&Game::OnKeyReleased, this, _1));
-  _eventManager->RegisterHandler(Event::LostFocus, bind(&Game::OnLostFocus, this, _1));
-  _eventManager->RegisterHandler(Event::GainedFocus, bind(&Game::OnGainedFocus, this, _1));
-  _eventManager->RegisterHandler(Event::MouseButtonReleased, bind(&Game::OnMouseButtonReleased, this, _1));
+  // when tracing from the command line, the recording starts before the level is generated
+  if (_settings.traceOnStart)
+    g_traceRecorder.Start(_settings.traceFile, _settings.traceFrames);
 
-  TwInit(TW_OPENGL, NULL);
-  TwWindowSize(_windowSize.x, _windowSize.y);
-  _twBar = TwNewBar("PangBar");
-  TwAddVarRW(_twBar, "WallDist", TW_TYPE_FLOAT, &g_behaviorSettings.wallDist, "min=0.1 max=10 step=0.1");
-  TwAddVarRW(_twBar, "WallForce", TW_TYPE_FLOAT, &g_behaviorSettings.wallForce, "min=0.1 max=10 step=0.1");
+  // the counters are per thread, so they're opened on the game thread. if the kernel denies
+  // access, the profiler just reports the timers
+  if (_settings.perfCounters)
+    g_perfCounters.Open();
 
 #ifdef WIN32
   string base("d:/projects/pang/");
 #else
   string base("/Users/dooz/projects/pang/");
 #endif
-  if (!_font.loadFromFile(base + "gfx/04b_03b_.ttf"))
+
+  // a replay runs with the seed and config it was recorded with
+  if (!_settings.replayFile.empty())
   {
-    return false;
+    if (!_inputLog.OpenRead(_settings.replayFile))
+      return false;
+    _replaying = true;
+    _settings.seed = _inputLog.Seed();
+    _settings.configFile = _inputLog.ConfigFile();
   }
 
-  if (!bristol::LoadProto((base + "config/game_large.pb").c_str(), &_gameConfig))
-    return false;
-
-  if (!_level.Init(_gameConfig))
-    return false;
-
-  if (!COORDINATOR.Create())
-    return false;
+  if (_settings.configFile.empty())
+    _settings.configFile = base + "config/game_large.pb";
 
-  // create local player
-  Vector2f p(0,0);
-  p = GetEmptyPos();
-  shared_ptr<Entity> e = make_shared<Entity>(_localPlayerId, p);
-  _entities[_localPlayerId] = e;
-
-  _level.SetEntity(WorldToTile(e->_pos), e->_id);
-
-  SpawnEnemies();
-
-  return true;
-}
-
-//----------------------------------------------------------------------------------
-Vector2f Game::GetEmptyPos()
-{
-  u32 w, h;
-  _level.GetSize(&w, &h);
-  while (true)
+  if (!_settings.recordFile.empty() && !_replaying)
   {
-    u32 x = rand() % w;
-    u32 y = rand() % h;
-    Level::Cell* cell = 0;
-    if (_level.GetCell(Tile(x, y), &cell) && cell->terrain == 0)
+    if (_settings.headless)
     {
-      return (float)_gridSize * Vector2f(x, y);
+      printf("recording needs a window\n");
+      return false;
     }
+
+    if (!_inputLog.OpenWrite(_settings.recordFile, _settings.seed, _settings.configFile))
+      return false;
+    _recording = true;
   }
-  return Vector2f(0,0);
-}
 
-//----------------------------------------------------------------------------------
-Vector2f Game::GetEmptyPos(const Vector2f& center, float radius)
-{
-  // find an empty position with LOS to the center
-  u32 w, h;
-  _level.GetSize(&w, &h);
-  Tile tile = WorldToTile(center);
-  u32 x0 = tile.x;
-  u32 y0 = tile.y;
-  while (true)
+  if (!_settings.headless)
   {
-    u32 x = (u32)((s32)x0 + randf(-radius, radius));
-    u32 y = (u32)((s32)y0 + randf(-radius, radius));
-    if (_level.IsValidPos(Tile(x, y)) /*&& _level.IsVisible(x0, y0, x, y)*/)
+    size_t width, height;
+#ifdef _WIN32
+    width = GetSystemMetrics(SM_CXFULLSCREEN);
+    height = GetSystemMetrics(SM_CYFULLSCREEN);
+#elif defined(__APPLE__)
+    auto displayId = CGMainDisplayID();
+    width = CGDisplayPixelsWide(displayId);
+    height = CGDisplayPixelsHigh(displayId);
+#else
+    sf::VideoMode desktop = sf::VideoMode::getDesktopMode();
+    width = desktop.width;
+    height = desktop.height;
+#endif
+
+    sf::ContextSettings contextSettings;
+    _windowSize = Vector2i(8 * width / 10, 8 * height / 10);
+    _renderWindow.reset(new RenderWindow(sf::VideoMode(_windowSize.x, _windowSize.y), "...", sf::Style::Default, contextSettings));
+    _renderWindow->setVerticalSyncEnabled(true);
+    _eventManager.reset(new WindowEventManager(_renderWindow.get()));
+
+    _eventManager->RegisterHandler(Event::KeyPressed, bind(&Game::OnKeyPressed, this, _1));
+    _eventManager->RegisterHandler(Event::KeyReleased, bind(&Game::OnKeyReleased, this, _1));
+    _eventManager->RegisterHandler(Event::LostFocus, bind(&Game::OnLostFocus, this, _1));
+    _eventManager->RegisterHandler(Event::GainedFocus, bind(&Game::OnGainedFocus, this, _1));
+    _eventManager->RegisterHandler(Event::MouseButtonReleased, bind(&Game::OnMouseButtonReleased, this, _1));
+
+    TwInit(TW_OPENGL, NULL);
+    TwWindowSize(_windowSize.x, _windowSize.y);
+    _twBar = TwNewBar("PangBar");
+    TwAddVarRW(_twBar, "WallDist", TW_TYPE_FLOAT, &g_behaviorSettings.wallDist, "min=0.1 max=10 step=0.1");
+    TwAddVarRW(_twBar, "WallForce", TW_TYPE_FLOAT, &g_behaviorSettings.wallForce, "min=0.1 max=10 step=0.1");
+
+#ifdef PANG_PROFILE
+    // rolling phase averages, in ms
+    TwAddVarRO(_twBar, "Frame", TW_TYPE_FLOAT, &g_frameProfiler._avgFrameMs, "group=Profile precision=3");
+    for (int i = 0; i < FrameProfiler::NUM_PHASES; ++i)
     {
-      // Check LOS to the center
-      return (float)_gridSize * Vector2f(x, y);
+      TwAddVarRO(_twBar, PhaseName((Phase)i), TW_TYPE_FLOAT, &g_frameProfiler._avgMs[i], "group=Profile precision=3");
     }
-  }
-  return Vector2f(0,0);
-}
-
-//----------------------------------------------------------------------------------
-void Game::SpawnEnemies()
-{
-  assert(_gameConfig.mobs_per_squad() < 16);
-  for (int i = 0; i < _gameConfig.num_squads(); ++i)
-  {
-    Vector2f squadCenter(GetEmptyPos());
-    for (int j = 0; j < _gameConfig.mobs_per_squad(); ++j)
+    TwAddVarRO(_twBar, "Allocs", TW_TYPE_UINT32, &g_frameProfiler._frameAllocs, "group=Profile");
+    if (g_perfCounters.IsOpen())
     {
-      EntityId idx = ((i+1) << 4) + j;
-      shared_ptr<Entity> e = make_shared<Entity>(idx, GetEmptyPos(squadCenter, 4));
-      e->_debug = new WanderDebugRenderer(e.get());
-      e->_squadId = i;
-      _entities[idx] = e;
+      // the labels have to be unique across the bar, so these are defined with explicit names
+      for (int i = 0; i < FrameProfiler::NUM_PHASES; ++i)
+      {
+        string name = string(PhaseName((Phase)i)) + "Ipc";
+        string def = string("group=Ipc precision=2 label='") + PhaseName((Phase)i) + "'";
+        TwAddVarRO(_twBar, name.c_str(), TW_TYPE_FLOAT, &g_frameProfiler._ipc[i], def.c_str());
+      }
+    }
+#endif
 
-      _level.SetEntity(WorldToTile(e->_pos), e->_id);
+    if (!_font.loadFromFile(base + "gfx/04b_03b_.ttf"))
+    {
+      return false;
     }
   }
-}
 
-//----------------------------------------------------------------------------------
-void Game::UpdateEnemies()
-{
-  if (_playerDead || _pausedEnemies)
-    return;
+  srand(_settings.seed);
+  if (!_sim.Init(_settings.configFile))
+    return false;
 
-  const float MAX_FORCE = 0.0005f;
+  // only count the level queries made while running
+  LEVEL_STATS(g_levelStats.Reset());
 
-  Entity* localPlayer = _entities[_localPlayerId].get();
+  if (!_settings.flightFile.empty())
+  {
+    if (!g_flightRecorder.Start(_settings.flightBufferMb << 20, _sim.TickDuration()))
+      return false;
+    g_flightRecorder.DumpOnCrash(_settings.flightFile);
+  }
 
-  Vector2f playerPos(localPlayer->_pos);
+  if (!_settings.snapshotName.empty() && !g_snapshotPublisher.Open(_settings.snapshotName, _sim))
+    return false;
 
-  for (auto& kv : _entities)
-  {
-    Entity* e = kv.second.get();
-    if (e->_id == _localPlayerId)
-      continue;
+  if (!_settings.checksumFile.empty() && !g_checksums.Open(_settings.checksumFile, _settings.checksumEntityInterval))
+    return false;
 
-//    e->_force = BehaviorPursuit(e, localPlayer);
-//    e->_force = 0.40f * BehaviorWander(e);
-    e->_force = 0.40f * BehaviorArrive(e, _entities[_localPlayerId]->_pos);
-    Level::Cell* cell;
-    if (_level.GetCell(WorldToTile(e->_pos), &cell))
-    {
-      e->_force += 0.60f * BehaviorAvoidWall(e, *cell);
-    }
+  if (!_settings.profileCsv.empty() && !g_frameProfiler.OpenCsv(_settings.profileCsv))
+    return false;
 
-    float len = min(MAX_FORCE, Length(e->_force));
-    Normalize(e->_force);
-    e->_force *= len;
+  g_frameProfiler.SetHitchBudget(_settings.hitchBudgetMs);
+  if (_settings.allocCheck)
+    g_frameProfiler.SetAllocCheck(_settings.allocWarmupFrames, _settings.allocCheckFatal);
 
-  }
+  if (!_settings.metricsFile.empty() && !g_metrics.Start(_settings.metricsFile, _settings.metricsIntervalMs))
+    return false;
 
-#if 0
-  for (auto& kv : _entities)
+  // the overlay is fed from the log, so it's always started with a window
+  if ((!_settings.headless || !_settings.logFile.empty()) && !g_asyncLog.Start(_settings.logFile, !_settings.headless))
+    return false;
+
+  if (!_settings.headless)
   {
-    Entity* e = kv.second.get();
-    if (e->_id == _localPlayerId)
-      continue;
+    CreateLevelTexture();
+    AttachDebugRenderers();
+  }
 
-    // turn towards player
-    Vector2f dir = (playerPos - e->_pos);
-    Normalize(dir);
+  return true;
+}
 
-    float a = atan2f(dir.x, dir.y);
-    e->_rot = a;
+//----------------------------------------------------------------------------------
+void Game::CreateLevelTexture()
+{
+  u32 w, h;
+  _sim.GetLevel().GetSize(&w, &h);
 
-    Vector2f dest(e->_pos + (float)_gridSize * dir);
-    Level::Cell* cell;
-    if (_level.GetCell(WorldToTile(dest), &cell))
-    {
-      // don't move to an occupied cell, or one which is another entity's dest
-      if ((cell->entityId && cell->entityId != e->_id) || (cell->destEntityId && cell->destEntityId != e->_id))
-        continue;
-    }
+  vector<u32> pixels;
+  _sim.GetLevel().GetPixels(&pixels);
 
-    AddMoveAction(e->_id, e->_pos, dest);
+  _levelTexture.create(w, h);
+  _levelTexture.update((const u8*)pixels.data());
+}
 
-    if (_debugDraw & 2)
-      AddMessage(MessageType::Debug, toString("dx: %.2f, dy: %.2f, a: %.2f", dir.x, dir.y, a));
+//----------------------------------------------------------------------------------
+void Game::AttachDebugRenderers()
+{
+  // the debug renderers live on the rendering side, so they are added to any entities
+  // the simulation has spawned since the last call, and dropped for the dead ones
+  const EntityStore& entities = _sim.Entities();
+  for (auto it = _debugRenderers.begin(); it != _debugRenderers.end(); )
+  {
+    if (entities.IsAlive(it->first))
+      ++it;
+    else
+      it = _debugRenderers.erase(it);
+  }
 
-    //SpawnBullet(e);
+  for (u32 e = 0; e < entities.Size(); ++e)
+  {
+    EntityId id = entities._id[e];
+    if (id != _sim.LocalPlayerId() && !_debugRenderers.count(id))
+      _debugRenderers[id].reset(new WanderDebugRenderer(&entities, id));
   }
-#endif
 }
 
-
 //----------------------------------------------------------------------------------
 bool Game::OnLostFocus(const Event& event)
 {
@@ -224,47 +348,50 @@ bool Game::OnGainedFocus(const Event& event)
 }
 
 //----------------------------------------------------------------------------------
-Vector2f Game::SnappedPos(const Vector2f& pos)
+void Game::HandleInput()
 {
-  float ff = (float)_gridSize;
-  float f = ff - 1;
-  int x = (int)((pos.x + f) / ff);
-  int y = (int)((pos.y + f) / ff);
-  return Vector2f(x * ff, y * ff);
+  u8 keys = 0;
+  if (Keyboard::isKeyPressed(Keyboard::Left) || Keyboard::isKeyPressed(Keyboard::A))
+    keys |= InputKeys::Left;
+  if (Keyboard::isKeyPressed(Keyboard::Right) || Keyboard::isKeyPressed(Keyboard::D))
+    keys |= InputKeys::Right;
+  if (Keyboard::isKeyPressed(Keyboard::Up) || Keyboard::isKeyPressed(Keyboard::W))
+    keys |= InputKeys::Up;
+  if (Keyboard::isKeyPressed(Keyboard::Down) || Keyboard::isKeyPressed(Keyboard::S))
+    keys |= InputKeys::Down;
+
+  ApplyKeys(keys);
 }
 
 //----------------------------------------------------------------------------------
-Vector2f Game::ClampedDestination(const Vector2f& pos, const Vector2f& dir)
+void Game::ApplyKeys(u8 keys)
 {
-  return SnappedPos(pos + (float)_gridSize * dir);
-}
+  _inputFrame.keys = keys;
 
-//----------------------------------------------------------------------------------
-void Game::HandleInput()
-{
-  if (_playerDead)
+  u32 e;
+  if (_sim.PlayerDead() || !_sim.FindLocalPlayer(&e))
     return;
 
-  Entity& e = *_entities[_localPlayerId];
+  EntityStore& entities = _sim.Entities();
 
-  u8 curLeft = Keyboard::isKeyPressed(Keyboard::Left) || Keyboard::isKeyPressed(Keyboard::A);
-  u8 curRight = Keyboard::isKeyPressed(Keyboard::Right) || Keyboard::isKeyPressed(Keyboard::D);
+  u8 curLeft = (keys & InputKeys::Left) != 0;
+  u8 curRight = (keys & InputKeys::Right) != 0;
 
   if (curLeft && !_prevLeft)
   {
-    e._rot -= PI/8;
+    entities._rot[e] -= PI/8;
   }
   else if (curRight && !_prevRight)
   {
-    e._rot += PI/8;
+    entities._rot[e] += PI/8;
   }
-  else if (Keyboard::isKeyPressed(Keyboard::Up) || Keyboard::isKeyPressed(Keyboard::W))
+  else if (keys & InputKeys::Up)
   {
-    e._force += 0.001f * e.Dir();
+    entities._force[e] += 0.001f * entities.Dir(e);
   }
-  else if (Keyboard::isKeyPressed(Keyboard::Down) || Keyboard::isKeyPressed(Keyboard::S))
+  else if (keys & InputKeys::Down)
   {
-    e._force -= 0.001f * e.Dir();
+    entities._force[e] -= 0.001f * entities.Dir(e);
   }
 
   _prevLeft = curLeft;
@@ -272,62 +399,117 @@ void Game::HandleInput()
 }
 
 //----------------------------------------------------------------------------------
-void Game::DebugDrawEntity()
+void Game::ApplyEvent(InputEvent event)
 {
-  if (!_selectedEntity)
-    return;
+  _inputFrame.events.push_back(event);
+
+  switch (event)
+  {
+    case InputEvent::Fire:
+      if (!_sim.PlayerDead())
+        _sim.SpawnBullet(_sim.LocalPlayerId());
+      break;
+
+    case InputEvent::SpawnEnemies:
+      _sim.SpawnEnemies();
+      if (!_settings.headless)
+        AttachDebugRenderers();
+      break;
 
-  const Entity& e = *_selectedEntity;
-  AddMessage(MessageType::Debug, to_string("id: %d", e._id));
-//  AddMessage(MessageType::Debug, toString("pos: x: %.2f, y: %.2f, rot: %.2f", e._pos.x, e._pos.y, e._rot));
+    case InputEvent::Quit:
+      _done = true;
+      break;
+  }
 }
 
+//----------------------------------------------------------------------------------
+void Game::EndInputFrame()
+{
+  if (_recording)
+    _inputLog.WriteFrame(_inputFrame);
+  _inputFrame.Clear();
+}
 
 //----------------------------------------------------------------------------------
-bool Game::SpawnBullet(Entity& e)
+bool Game::ReplayFrame()
 {
-  #if 0
-  if (e._lastAction.is_not_a_date_time())
-  {
-    e._lastAction = _now;
-  }
-  else if (_now - e._lastAction < seconds(1))
+  if (!_inputLog.ReadFrame(&_replayFrame))
   {
+    _done = true;
     return false;
   }
 
-  e._lastAction = _now;
+  for (InputEvent event : _replayFrame.events)
+    ApplyEvent(event);
+
+  if (_replayFrame.updated)
+  {
+    {
+      PROFILE_PHASE(HandleInput);
+      ApplyKeys(_replayFrame.keys);
+    }
+
+    _sim.Update(_replayFrame.delta_us);
+    g_snapshotPublisher.Publish(_sim);
+  }
 
-  Vector2f c(_gridSize/2, _gridSize/2);
+  _inputFrame.Clear();
+  return true;
+}
 
-  Vector2f dir = Vector2f(sinf(e._rot), -cosf(e._rot));
-  Vector2f pos = SnappedPos(e._pos) + c + (float)_gridSize * dir;
-  if (_level.IsValidPos(WorldToTile(pos)))
+//----------------------------------------------------------------------------------
+void Game::DebugDrawEntity()
+{
+#ifdef PANG_PROFILE
+  if (_debugDraw.IsSet(DebugDrawFlags::CostInfo))
   {
-    ActionBullet* b = new ActionBullet(e._id);
-    b->pos = pos;
-    b->dir = dir;
-    _actionQueue.push_back(b);
+    // the costliest behaviors and squads over the last sampling window
+    vector<pair<CostKind, float>> kinds;
+    g_costAttribution.TopKinds(true, NUM_TOP_COSTS, &kinds);
+    for (const auto& k : kinds)
+      g_asyncLog.Write(LogLevel::Debug, "%s: %.1f us", CostKindName(k.first), k.second);
+
+    vector<pair<SquadId, float>> squads;
+    g_costAttribution.TopSquads(true, NUM_TOP_COSTS, &squads);
+    for (const auto& s : squads)
+    {
+      if (s.first == NO_SQUAD)
+        g_asyncLog.Write(LogLevel::Debug, "player: %.1f us", s.second);
+      else
+        g_asyncLog.Write(LogLevel::Debug, "squad %d: %.1f us", s.first, s.second);
+    }
   }
 #endif
-  return true;
+
+  // the selection is dropped once the entity is gone
+  u32 e;
+  if (!_sim.Entities().Find(_selectedEntity, &e))
+  {
+    _selectedEntity = NO_ENTITY;
+    return;
+  }
+
+  g_asyncLog.Write(LogLevel::Debug, "id: %u", _selectedEntity);
+//  AddMessage(MessageType::Debug, toString("pos: x: %.2f, y: %.2f, rot: %.2f", _sim.Entities()._pos[e].x, _sim.Entities()._pos[e].y, _sim.Entities()._rot[e]));
 }
 
+
 //----------------------------------------------------------------------------------
 bool Game::OnMouseButtonReleased(const Event& event)
 {
   // the view is centered around the local player, so compensate for this
   const Vector2f& p = _renderWindow->mapPixelToCoords(Vector2i(event.mouseButton.x, event.mouseButton.y));
-  Tile tile = WorldToTile(p);
+  Tile tile = _sim.WorldToTile(p);
 
-  _selectedEntity.reset();
+  _selectedEntity = NO_ENTITY;
 
-  for (const auto& kv : _entities)
+  const EntityStore& entities = _sim.Entities();
+  for (u32 e = 0; e < entities.Size(); ++e)
   {
-    Tile entityTile = WorldToTile(kv.second->_pos);
+    Tile entityTile = _sim.WorldToTile(entities._pos[e]);
     if (entityTile == tile)
     {
-      _selectedEntity = kv.second;
+      _selectedEntity = entities._id[e];
       break;
     }
   }
@@ -340,29 +522,22 @@ bool Game::OnKeyPressed(const Event& event)
 {
   Keyboard::Key key = event.key.code;
 
-  if (_playerDead)
+  // a replay only takes its input from the recording, but can still be stopped
+  if (_replaying)
   {
-    switch (key)
-    {
-      case Keyboard::Escape:
-        _done = true;
-        break;
-    }
+    if (key == Keyboard::Escape)
+      _done = true;
     return true;
   }
 
-  Entity& e = *_entities[_localPlayerId].get();
-
   switch (key)
   {
     case Keyboard::Space:
-    {
-      SpawnBullet(e);
+      ApplyEvent(InputEvent::Fire);
       break;
-    }
 
     case Keyboard::Escape:
-      _done = true;
+      ApplyEvent(InputEvent::Quit);
       break;
   }
 
@@ -379,7 +554,13 @@ bool Game::OnKeyReleased(const Event& event)
     case Keyboard::Num3: _debugDraw.Toggle(DebugDrawFlags::BehaviorInfo); break;
     case Keyboard::Num4: _debugDraw.Toggle(DebugDrawFlags::PlayerCone); break;
     case Keyboard::Num5: _debugDraw.Toggle(DebugDrawFlags::DrawLevel); break;
-    case Keyboard::R: SpawnEnemies(); break;
+    case Keyboard::Num6: _debugDraw.Toggle(DebugDrawFlags::CostInfo); break;
+    case Keyboard::R: if (!_replaying) ApplyEvent(InputEvent::SpawnEnemies); break;
+    case Keyboard::T: g_traceRecorder.Start(_settings.traceFile, _settings.traceFrames); break;
+    case Keyboard::F:
+      if (g_flightRecorder.Dump(_settings.flightFile, _settings.flightSeconds))
+        g_asyncLog.Write(LogLevel::Info, "flight recording written to %s", _settings.flightFile.c_str());
+      break;
   }
 
   return true;
@@ -388,17 +569,18 @@ bool Game::OnKeyReleased(const Event& event)
 //----------------------------------------------------------------------------------
 void Game::DrawGrid()
 {
-  float g = (float)_gridSize;
+  float g = (float)_sim.GridSize();
   _levelSprite.setPosition(0, 0);
-  _levelSprite.setTexture(_level.GetTexture());
+  _levelSprite.setTexture(_levelTexture);
   _levelSprite.setScale(g, g);
   _renderWindow->draw(_levelSprite);
 
-  vector<sf::Vertex> lines;
+  vector<sf::Vertex>& lines = _gridVertices;
+  lines.clear();
   Color c(0x80, 0x80, 0x80);
 
   u32 w, h;
-  _level.GetSize(&w, &h);
+  _sim.GetLevel().GetSize(&w, &h);
 
   // horizontal
   float x = w * g;
@@ -424,224 +606,90 @@ void Game::DrawGrid()
 
 }
 
-//----------------------------------------------------------------------------------
-void Game::UpdateVisibility()
-{
-  for (auto& kv : _entities)
-  {
-    shared_ptr<Entity>& e = kv.second;
-    e->_visibleEntities.clear();
-    bool localPlayer = e->_id == _localPlayerId;
-
-    float distSq = e->_viewDistance * e->_viewDistance;
-    const Vector2f& pos = e->_pos;
-    const Vector2f& dir = e->Dir();
-
-    const Tile& t0 = WorldToTile(pos);
-
-    for (auto& innerKv : _entities)
-    {
-      shared_ptr<Entity>& e2 = innerKv.second;
-      if (e->_id == e2->_id || (localPlayer == (e2->_id == _localPlayerId)) )
-        continue;
-
-      // first, check distance
-      float tmp = DistSq(e->_pos, e2->_pos);
-      if (tmp > distSq)
-        continue;
-
-      // check angle between direction vector and vector to entity
-      Vector2f toEntity(Normalize(e2->_pos - pos));
-
-      // dot(a,b) = cos(theta)
-      float angle = acosf(Dot(toEntity, dir));
-      if (angle < e->_fov)
-      {
-        // do a LOS check
-        vector<Vector2i> path;
-        const Tile& t1 = WorldToTile(e2->_pos);
-
-        if (_level.IsVisible(t0.x, t0.y, t1.x, t1.y))
-        {
-          e->_visibleEntities.push_back(e2->_id);
-          if (!localPlayer)
-          {
-            // monster has spotted the player, so report it
-            COORDINATOR.SendMessage(AiMessage::MakePlayerSpotted(e2->_pos));
-            //AddMessage(MessageType::Debug, toString("player spotted by: %hd", e->_id));
-          }
-        }
-      }
-    }
-  }
-}
-
-//----------------------------------------------------------------------------------
-void Game::PhysicsUpdate(float delta_ms)
-{
-  // verlet integration:
-  // xi+1 = xi + (xi - xi-1) + a * dt * dt
-
-  float deltaSq = delta_ms * delta_ms;
-  float invDelta = 1.0f / delta_ms;
-
-  for (const auto& kv : _entities)
-  {
-    Entity* e = kv.second.get();
-    Vector2f prevPos = e->_pos;
-    // F = m/a => a = F/m
-    Vector2f damping = -0.001f * e->_vel;
-    e->_acc = (e->_force + damping) * e->_invMass;
-    e->_force = Vector2f(0,0);
-    Vector2f newPos = e->_pos + (e->_pos - e->_prevPos) + e->_acc * deltaSq;
-
-    Level::Cell* cell;
-    if (!_level.GetCell(WorldToTile(newPos), &cell) || cell->terrain > 0)
-    {
-      // penetration, so project the entity backwards
-      Vector2f dir = (newPos - prevPos);
-      e->_pos -= dir;
-      e->_collision = true;
-    }
-    else
-    {
-      e->_pos = newPos;
-      e->_collision = false;
-    }
-    e->_vel = (e->_pos - e->_prevPos) * invDelta;
-    e->_prevPos = prevPos;
-
-    if (e->_id != _localPlayerId)
-      e->_rot = atan2f(e->_vel.x, -e->_vel.y);
-  }
-}
-
 //----------------------------------------------------------------------------------
 void Game::Update()
 {
-  _now = microsec_clock::local_time();
-  if (_lastUpdate.is_not_a_date_time())
-  {
-    _lastUpdate = _now;
-    return;
-  }
-
+  TRACE_SCOPE("Game::Update");
   _eventManager->Poll();
 
+  u64 now = _clock->NowUs();
+  u64 delta_us = now - _lastUpdate;
+  _lastUpdate = now;
 
-  u64 delta_us = (_now - _lastUpdate).total_microseconds();
-  _lastUpdate = _now;
-
-  if (_debugDraw.IsSet(DebugDrawFlags::DrawLevel))
-    return;
-
-  HandleInput();
-
-  // calc the number of physics ticks to take (the physics run with a fixed time step)
-  static const u64 tickFreq = 100;
-  static const u64 tick_us = (u64)(1e6f / tickFreq);
-
-  float delta_s = delta_us / 1e6f;
-  _tickAcc += delta_us;
-  while (_tickAcc > tick_us)
+  if (_replaying)
   {
-    PhysicsUpdate(tick_us / 1000);
-    _tickAcc -= tick_us;
+    ReplayFrame();
+    return;
   }
 
-
-  UpdateVisibility();
-
-  Level::Cell* cell;
-  if (_level.GetCell(WorldToTile(_entities[_localPlayerId]->_pos), &cell))
-    cell->heat = 255;
-
-  UpdateBullets(delta_s);
-
-  COORDINATOR.Update();
-  UpdateEnemies();
-
-}
-
-
-//----------------------------------------------------------------------------------
-void Game::UpdateBullets(float delta_s)
-{
-  for (auto it = _bullets.begin(); it != _bullets.end();)
+  if (!_debugDraw.IsSet(DebugDrawFlags::DrawLevel))
   {
-    Bullet& b = *it;
-    b.pos = b.pos + 100 * delta_s * b.dir;
-    if (!_level.IsValidPos(WorldToTile(b.pos)))
     {
-      it = _bullets.erase(it);
+      PROFILE_PHASE(HandleInput);
+      HandleInput();
     }
-    else
-    {
-      bool collision = false;
-      // check for player collision
-      for (auto j = _entities.begin(); j != _entities.end();)
-      {
-        shared_ptr<Entity> e = j->second;
-        if (e->_id != b.entityId && SnappedPos(e->_pos) == SnappedPos(b.pos))
-        {
-          collision = true;
-          if (e->_id == _localPlayerId)
-            _playerDead = true;
-          _deadEntites[e->_id] = e;
-          _entities.erase(j);
-          break;
-        }
-        else
-        {
-          ++j;
-        }
-      }
 
-      it = collision ? _bullets.erase(it) : ++it;
-    }
+    _sim.Update(delta_us);
+    g_snapshotPublisher.Publish(_sim);
+    _inputFrame.updated = true;
+    _inputFrame.delta_us = delta_us;
   }
 
+  EndInputFrame();
 }
 
 //----------------------------------------------------------------------------------
 void Game::Render()
 {
+  TRACE_SCOPE("Game::Render");
   _renderWindow->clear();
 
   if (_debugDraw.IsSet(DebugDrawFlags::DrawLevel))
   {
     float s = 4;
     _levelSprite.setPosition(0, 0);
-    _levelSprite.setTexture(_level.GetTexture());
+    _levelSprite.setTexture(_levelTexture);
     _levelSprite.setScale(s, s);
     _renderWindow->draw(_levelSprite);
   }
   else
   {
-    if (!_playerDead)
+    u32 localPlayer;
+    if (!_sim.PlayerDead() && _sim.FindLocalPlayer(&localPlayer))
     {
       Vector2u s = _renderWindow->getSize();
-      _view.setCenter(_entities[_localPlayerId]->_pos);
+      _view.setCenter(_sim.Entities()._pos[localPlayer]);
       _view.setRotation(0);
       _view.setSize(VectorCast<float>(s));
       _renderWindow->setView(_view);
     }
 
-//  _level.Diffuse();
-//  _level.UpdateTexture();
-    DrawGrid();
-    DrawEntities();
+//  _sim.GetLevel().Diffuse();
+//  _sim.GetLevel().UpdateHeat(&pixels);
+    {
+      PROFILE_PHASE(DrawGrid);
+      DrawGrid();
+    }
+
+    {
+      PROFILE_PHASE(DrawEntities);
+      DrawEntities();
+    }
 
     DebugDrawEntity();
 
-    if (_playerDead)
+    if (_sim.PlayerDead())
     {
-      AddMessage(MessageType::Debug, "** GAME OVER **");
+      g_asyncLog.Write(LogLevel::Debug, "** GAME OVER **");
     }
   }
 
-  UpdateMessages();
+  {
+    PROFILE_PHASE(UpdateMessages);
+    UpdateMessages();
+  }
 
+  TRACE_SCOPE("Display");
   TwDraw();
 
   _renderWindow->display();
@@ -650,57 +698,78 @@ void Game::Render()
 //----------------------------------------------------------------------------------
 void Game::DrawEntities()
 {
-  float g = (float)_gridSize;
+  float g = (float)_sim.GridSize();
   Vector2f ofs(g/2, g/2);
+  EntityId localPlayerId = _sim.LocalPlayerId();
 
-  for (const auto& kv : _entities)
+  // the triangles go in a single draw. the vertices, shapes and labels are kept between
+  // frames, so a frame doesn't allocate once every entity has been drawn
+  const EntityStore& entities = _sim.Entities();
+  _entityVertices.clear();
+  for (u32 e = 0; e < entities.Size(); ++e)
   {
-    const Entity& e = *kv.second;
-    VertexArray triangle(sf::Triangles, 3);
+    const Vector2f& pos = entities._pos[e];
     Transform rotation;
-    Color col = e._id == _localPlayerId ? Color::Green : Color::Yellow;
-    rotation.rotate(180 * e._rot / PI);
-    triangle[0].position = ofs + e._pos + rotation.transformPoint(Vector2f(0, -g/2));
-    triangle[0].color = Color::Red;
-    triangle[1].position = ofs + e._pos + rotation.transformPoint(Vector2f(-5, 0.75f * g/2));
-    triangle[1].color = col;
-    triangle[2].position = ofs + e._pos + rotation.transformPoint(Vector2f(5, 0.75f * g/2));
-    triangle[2].color = col;
-    _renderWindow->draw(triangle);
-
-    if (e._id == _localPlayerId)
-    {
-      RectangleShape rect;
-      rect.setPosition(e._pos);
-      rect.setSize(Vector2f(_gridSize, _gridSize));
-      rect.setFillColor(Color(150, e.ReadCollision() ? 0 : 150, 0, 150));
-      _renderWindow->draw(rect);
+    Color col = entities._id[e] == localPlayerId ? Color::Green : Color::Yellow;
+    rotation.rotate(180 * entities._rot[e] / PI);
+    _entityVertices.push_back(sf::Vertex(ofs + pos + rotation.transformPoint(Vector2f(0, -g/2)), Color::Red));
+    _entityVertices.push_back(sf::Vertex(ofs + pos + rotation.transformPoint(Vector2f(-5, 0.75f * g/2)), col));
+    _entityVertices.push_back(sf::Vertex(ofs + pos + rotation.transformPoint(Vector2f(5, 0.75f * g/2)), col));
+  }
+  _renderWindow->draw(_entityVertices.data(), _entityVertices.size(), sf::Triangles);
+
+  for (u32 e = 0; e < entities.Size(); ++e)
+  {
+    EntityId id = entities._id[e];
+    const Vector2f& pos = entities._pos[e];
+    float rot = entities._rot[e];
+
+    if (id == localPlayerId)
+    {
+      _playerRect.setPosition(pos);
+      _playerRect.setSize(Vector2f(g, g));
+      _playerRect.setFillColor(Color(150, entities._collision[e] ? 0 : 150, 0, 150));
+      _renderWindow->draw(_playerRect);
 
       if (_debugDraw.IsSet(DebugDrawFlags::PlayerInfo))
       {
-        AddMessage(MessageType::Debug, to_string("x: %.2f, y: %.2f", e._pos.x, e._pos.y));
+        g_asyncLog.Write(LogLevel::Debug, "x: %.2f, y: %.2f", pos.x, pos.y);
       }
 
       // draw the visibility cone
       if (_debugDraw.IsSet(DebugDrawFlags::PlayerCone))
       {
-        ArcShape aa(e._pos + ofs, e._viewDistance, e._rot - e._fov, e._rot + e._fov);
-        aa.setFillColor(Color(e._visibleEntities.empty() ? 200 : 0, 200, 0, 100));
+        float fov = entities._fov[e];
+        ArcShape aa(pos + ofs, entities._viewDistance[e], rot - fov, rot + fov);
+        aa.setFillColor(Color(_sim.Visibility().Visible(id).empty() ? 200 : 0, 200, 0, 100));
         _renderWindow->draw(aa);
       }
 
     }
     else
     {
+      // a label is laid out the first time its entity is drawn
+      u32 index = EntityIndex(id);
+      if (index >= _entityLabels.size())
+        _entityLabels.resize(entities.NumHandles());
 
-      sf::Text text(to_string("%d (%d)", e._id, e._squadId), _font);
-      text.setCharacterSize(16);
-      text.setPosition(e._pos.x, e._pos.y+10);
-      _renderWindow->draw(text);
+      EntityLabel& label = _entityLabels[index];
+      if (label.id != id || label.squadId != entities._squadId[e])
+      {
+        label.id = id;
+        label.squadId = entities._squadId[e];
+        label.text.setFont(_font);
+        label.text.setCharacterSize(16);
+        label.text.setString(to_string("%u (%d)", id, entities._squadId[e]));
+      }
+      label.text.setPosition(pos.x, pos.y+10);
+      _renderWindow->draw(label.text);
 
-      if (e._debug && _debugDraw.IsSet(DebugDrawFlags::BehaviorInfo))
+      if (_debugDraw.IsSet(DebugDrawFlags::BehaviorInfo))
       {
-        e._debug->Render(_renderWindow.get());
+        auto it = _debugRenderers.find(id);
+        if (it != _debugRenderers.end())
+          it->second->Render(_renderWindow.get());
       }
 
     }
@@ -708,15 +777,14 @@ void Game::DrawEntities()
   }
 
   // draw bullets
-  RectangleShape rect;
-  rect.setFillColor(Color::Red);
-  rect.setSize(Vector2f(6, 6));
+  _bulletRect.setFillColor(Color::Red);
+  _bulletRect.setSize(Vector2f(6, 6));
   Vector2f bulletOfs(0, 3);
 
-  for (const Bullet& b : _bullets)
+  for (const Bullet& b : _sim.Bullets())
   {
-    rect.setPosition(b.pos - bulletOfs);
-    _renderWindow->draw(rect);
+    _bulletRect.setPosition(b.pos - bulletOfs);
+    _renderWindow->draw(_bulletRect);
   }
 
 }
@@ -724,18 +792,94 @@ void Game::DrawEntities()
 //----------------------------------------------------------------------------------
 bool Game::Run()
 {
+  if (!_settings.sampleFile.empty() && !g_sampler.Start(_settings.sampleHz))
+    printf("unable to start the sampling profiler\n");
+
+  if (_settings.headless)
+    return RunHeadless();
+
+  // the time spent loading isn't simulated
+  _lastUpdate = _clock->NowUs();
   while (_renderWindow->isOpen() && !_done)
   {
+    PROFILE_BEGIN_FRAME();
     Update();
     Render();
+    PROFILE_END_FRAME();
+    g_traceRecorder.EndFrame();
+    LEVEL_STATS(g_levelStats.EndFrame());
+    g_asyncLog.EndFrame();
   }
 
   return true;
 }
 
+//----------------------------------------------------------------------------------
+bool Game::RunHeadless()
+{
+  // the simulated clock advances one physics tick per update, so the simulation runs as
+  // fast as the cpu allows, independent of wall time
+  SetClock(&_manualClock);
+  _lastUpdate = _clock->NowUs();
+
+  u64 startNs = NowNs();
+
+  while ((_replaying || _sim.NumTicks() < _settings.numTicks) && !_done)
+  {
+    PROFILE_BEGIN_FRAME();
+    if (_replaying)
+    {
+      // the recorded deltas are used as is
+      ReplayFrame();
+    }
+    else
+    {
+      _manualClock.Advance(_sim.TickDuration());
+      u64 now = _clock->NowUs();
+      _sim.Update(now - _lastUpdate);
+      g_snapshotPublisher.Publish(_sim);
+      _lastUpdate = now;
+    }
+    PROFILE_END_FRAME();
+    g_traceRecorder.EndFrame();
+    LEVEL_STATS(g_levelStats.EndFrame());
+    g_asyncLog.EndFrame();
+  }
+
+  double elapsed_s = (NowNs() - startNs) / 1e9;
+  printf("%u ticks, %u entities in %.3f s: %.1f ticks/sec\n",
+      _sim.NumTicks(), _sim.Entities().Size(), elapsed_s, elapsed_s > 0 ? _sim.NumTicks() / elapsed_s : 0.0);
+  if (_replaying)
+    printf("replayed %u updates from %s\n", _inputLog.NumFrames(), _settings.replayFile.c_str());
+
+  return true;
+}
+
 //------------------------------------------------------------------------------
 bool Game::Close()
 {
+  g_sampler.Stop();
+  if (!_settings.sampleFile.empty())
+    g_sampler.Write(_settings.sampleFile);
+
+  if (g_flightRecorder.IsRecording())
+  {
+    g_flightRecorder.Dump(_settings.flightFile, _settings.flightSeconds);
+    g_flightRecorder.Stop();
+  }
+
+  g_frameProfiler.PrintSummary();
+  g_frameProfiler.Close();
+  g_costAttribution.PrintSummary(NUM_TOP_COSTS);
+  LEVEL_STATS(g_levelStats.PrintSummary());
+  g_metrics.Stop();
+  g_snapshotPublisher.Close();
+  g_checksums.Close();
+
+  if (_recording)
+    printf("recorded %u updates to %s\n", _inputLog.NumFrames(), _settings.recordFile.c_str());
+  _inputLog.Close();
+  g_asyncLog.Stop();
   return true;
 }
 
@@ -744,6 +888,7 @@ void Game::AddMessage(MessageType type, const string& str)
 {
   Message msg;
   msg.str = str;
+  msg.endTimeUs = 0;
 
   if (type == MessageType::Debug)
   {
@@ -754,43 +899,50 @@ void Game::AddMessage(MessageType type, const string& str)
   {
     u8 c = (u8)(255 * 0.8f);
     msg.color = Color(c, c, c);
-    msg.endTime = microsec_clock::local_time() + seconds(5);
+    msg.endTimeUs = _clock->NowUs() + 5 * 1000000;
   }
   else if (type == MessageType::Warning)
   {
     msg.color = Color((u8)(0.9f * 255), (u8)(0.9f * 255), 0);
-    msg.endTime = microsec_clock::local_time() + seconds(10);
+    msg.endTimeUs = _clock->NowUs() + 10 * 1000000;
   }
   else
   {
     // error
     msg.color = Color((u8)(0.9f * 255), (u8)(0.2f * 255), 0);
-    msg.endTime = microsec_clock::local_time() + seconds(20);
+    msg.endTimeUs = _clock->NowUs() + 20 * 1000000;
   }
 
   _messages.push_back(msg);
 }
 
 //------------------------------------------------------------------------------
-Tile Game::WorldToTile(const Vector2f& p) const
+void Game::UpdateMessages()
 {
-  float g = _gridSize;
-  float ofs = g / 2;
-  return Tile((u32)((p.x + ofs) / g), (u32)((p.y + ofs)/ g));
-}
+  g_asyncLog.TakeLines(&_logLines);
+  for (const LogLine& line : _logLines)
+  {
+    if (line.level == LogLevel::Debug)
+    {
+      if (line.frame != _debugFrame)
+      {
+        _debugLines.clear();
+        _debugFrame = line.frame;
+      }
+      _debugLines.push_back(line.str);
+    }
+    else
+    {
+      AddMessage(line.level, line.str);
+    }
+  }
 
-//------------------------------------------------------------------------------
-Vector2f Game::TileToWorld(u32 x, u32 y) const
-{
-  // returns a point in the center of the tile
-  float g = (float)_gridSize;
-  return Vector2f(x * g + g / 2, y * g + g / 2);
-}
+  if (g_asyncLog.Frame() - _debugFrame > DEBUG_LINE_FRAMES)
+    _debugLines.clear();
 
-//------------------------------------------------------------------------------
-void Game::UpdateMessages()
-{
-  ptime now = microsec_clock::local_time();
+  g_metrics.Set(Metric::Messages, _messages.size() + _debugLines.size());
+
+  u64 now = _clock->NowUs();
 
   Vector2f pos = _renderWindow->mapPixelToCoords(Vector2i(300, 0));
   float x = pos.x;
@@ -798,23 +950,31 @@ void Game::UpdateMessages()
   RectangleShape rect;
   rect.setPosition(x, y);
   rect.setFillColor(Color(128, 128, 128, 128));
-  rect.setSize(Vector2f(16*40, (float)17 * _messages.size()));
+  rect.setSize(Vector2f(16*40, (float)17 * (_messages.size() + _debugLines.size())));
   _renderWindow->draw(rect);
 
   Text text;
   text.setFont(_font);
   text.setCharacterSize(16);
 
+  for (const string& str : _debugLines)
+  {
+    text.setPosition(x, y);
+    text.setString(str);
+    _renderWindow->draw(text);
+    y += 16;
+  }
+
   for (auto it = _messages.begin(); it != _messages.end(); )
   {
     Message& msg = *it;
-    if (msg.endTime.is_not_a_date_time() || msg.endTime > now)
+    if (msg.endTimeUs == 0 || msg.endTimeUs > now)
     {
       // blend out alpha over the last second
-      time_duration left = msg.endTime - now;
-      if (left < seconds(1))
+      u64 left = msg.endTimeUs - now;
+      if (msg.endTimeUs != 0 && left < 1000000)
       {
-        msg.color.a = (u8)(255 * left.total_milliseconds() / 1000.0f);
+        msg.color.a = (u8)(255 * left / 1000000.0f);
       }
 
       text.setPosition(x, y);
@@ -823,7 +983,7 @@ void Game::UpdateMessages()
       y += 16;
     }
 
-    if (!msg.endTime.is_not_a_date_time() && msg.endTime > now)
+    if (msg.endTimeUs != 0 && msg.endTimeUs > now)
     {
       ++it;
     }
@@ -838,9 +998,126 @@ void Game::UpdateMessages()
 //------------------------------------------------------------------------------
 int main(int argc, char* argv[])
 {
+  GameSettings settings;
+
+  // pang [--headless <config> <ticks>] [--profile-csv <file>] [--trace <file> <frames>]
+  //      [--hitch-budget <ms>] [--alloc-check <warmup frames>] [--alloc-assert <warmup frames>]
+  //      [--metrics <file> <interval ms>] [--sample <file> <hz>] [--perf-counters]
+  //      [--log <file>] [--flight <file> <seconds>] [--flight-csv <dump> <csv>]
+  //      [--publish <name>] [--view <name>] [--seed <n>] [--record <file>]
+  //      [--replay <file>] [--replay-headless <file>] [--checksum <file>]
+  //      [--checksum-entities <interval ticks>] [--checksum-compare <file a> <file b>]
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "--headless") == 0 && i + 2 < argc)
+    {
+      settings.headless = true;
+      settings.configFile = argv[++i];
+      settings.numTicks = (u32)atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--profile-csv") == 0 && i + 1 < argc)
+    {
+      settings.profileCsv = argv[++i];
+    }
+    else if (strcmp(argv[i], "--trace") == 0 && i + 2 < argc)
+    {
+      settings.traceFile = argv[++i];
+      settings.traceFrames = (u32)atoi(argv[++i]);
+      settings.traceOnStart = true;
+    }
+    else if (strcmp(argv[i], "--hitch-budget") == 0 && i + 1 < argc)
+    {
+      settings.hitchBudgetMs = (float)atof(argv[++i]);
+    }
+    else if ((strcmp(argv[i], "--alloc-check") == 0 || strcmp(argv[i], "--alloc-assert") == 0) && i + 1 < argc)
+    {
+      settings.allocCheck = true;
+      settings.allocCheckFatal = strcmp(argv[i], "--alloc-assert") == 0;
+      settings.allocWarmupFrames = (u32)atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--metrics") == 0 && i + 2 < argc)
+    {
+      settings.metricsFile = argv[++i];
+      settings.metricsIntervalMs = (u32)atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--perf-counters") == 0)
+    {
+      settings.perfCounters = true;
+    }
+    else if (strcmp(argv[i], "--sample") == 0 && i + 2 < argc)
+    {
+      settings.sampleFile = argv[++i];
+      settings.sampleHz = (u32)atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc)
+    {
+      settings.logFile = argv[++i];
+    }
+    else if (strcmp(argv[i], "--flight") == 0 && i + 2 < argc)
+    {
+      settings.flightFile = argv[++i];
+      settings.flightSeconds = (float)atof(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--flight-csv") == 0 && i + 2 < argc)
+    {
+      // converts a dump, and exits
+      const char* dumpFile = argv[++i];
+      const char* csvFile = argv[++i];
+      return FlightRecorder::WriteCsv(dumpFile, csvFile) ? 0 : 1;
+    }
+    else if (strcmp(argv[i], "--publish") == 0 && i + 1 < argc)
+    {
+      settings.snapshotName = argv[++i];
+    }
+    else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+    {
+      settings.seed = (u32)atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+    {
+      settings.recordFile = argv[++i];
+    }
+    else if ((strcmp(argv[i], "--replay") == 0 || strcmp(argv[i], "--replay-headless") == 0) && i + 1 < argc)
+    {
+      settings.headless = strcmp(argv[i], "--replay-headless") == 0;
+      settings.replayFile = argv[++i];
+    }
+    else if (strcmp(argv[i], "--checksum") == 0 && i + 1 < argc)
+    {
+      settings.checksumFile = argv[++i];
+    }
+    else if (strcmp(argv[i], "--checksum-entities") == 0 && i + 1 < argc)
+    {
+      settings.checksumEntityInterval = (u32)atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--checksum-compare") == 0 && i + 2 < argc)
+    {
+      // reports where two checksum streams diverge, and exits
+      const char* fileA = argv[++i];
+      const char* fileB = argv[++i];
+      return ChecksumStream::Compare(fileA, fileB) ? 0 : 1;
+    }
+    else if (strcmp(argv[i], "--view") == 0 && i + 1 < argc)
+    {
+      // watches a simulation published with --publish, and exits
+      return RunViewer(argv[++i]);
+    }
+    else
+    {
+      printf("usage: %s [--headless <config> <ticks>] [--profile-csv <file>] [--trace <file> <frames>]\n"
+          "    [--hitch-budget <ms>] [--alloc-check <warmup frames>] [--alloc-assert <warmup frames>]\n"
+          "    [--metrics <file> <interval ms>] [--sample <file> <hz>] [--perf-counters]\n"
+          "    [--log <file>] [--flight <file> <seconds>] [--flight-csv <dump> <csv>]\n"
+          "    [--publish <name>] [--view <name>] [--seed <n>] [--record <file>]\n"
+          "    [--replay <file>] [--replay-headless <file>] [--checksum <file>]\n"
+          "    [--checksum-entities <interval ticks>] [--checksum-compare <file a> <file b>]\n", argv[0]);
+      return 1;
+    }
+  }
+
   Game game;
 
-  if (!game.Init())
+  if (!game.Init(settings))
     return 1;
 
   game.Run();
@@ -1,63 +1,101 @@
 #pragma once
 #include "types.hpp"
-#include "entity.hpp"
-#include "level.hpp"
-#include "protocol/game.pb.h"
+#include "simulation.hpp"
+#include "async_log.hpp"
+#include "input_log.hpp"
+#include "clock.hpp"
+#include "debug_renderer.hpp"
 
 namespace pang
 {
   class WindowEventManager;
 
-  enum class MessageType
-  {
-    Debug,
-    Info,
-    Warning,
-    Error,
-  };
+  typedef LogLevel MessageType;
 
-
-  struct Bullet
+  struct GameSettings
   {
-    u16 entityId;
-    Vector2f dir;
-    Vector2f pos;
+    GameSettings();
+    // path to the game config. the level config is loaded from the same directory
+    string configFile;
+    // run the simulation without a window, for the given number of physics ticks
+    bool headless;
+    u32 numTicks;
+    // per-frame phase timings are written here, if set. requires PANG_PROFILE
+    string profileCsv;
+    // chrome trace output. recording is started from the command line, or with T
+    string traceFile;
+    u32 traceFrames;
+    bool traceOnStart;
+    // frames taking longer than this get their phase breakdown dumped. 0 disables
+    float hitchBudgetMs;
+    // report (or abort on, if allocCheckFatal) allocations in any phase once
+    // allocWarmupFrames frames have run. requires PANG_PROFILE. UpdateMessages isn't
+    // checked, as messages are copied in as they're logged. the behavior and view cone
+    // debug draws (keys 3 and 4) allocate, so in a window the check holds with those off
+    bool allocCheck;
+    bool allocCheckFatal;
+    u32 allocWarmupFrames;
+    // a snapshot of the runtime metrics is written here every metricsIntervalMs, if set.
+    // a .prom extension gives Prometheus text format, anything else json
+    string metricsFile;
+    u32 metricsIntervalMs;
+    // samples the call stack sampleHz times a second while running, and writes folded
+    // stacks to sampleFile at exit, if set. not available on windows
+    string sampleFile;
+    u32 sampleHz;
+    // collect cycles, instructions, cache and branch misses per phase through
+    // perf_event_open. requires PANG_PROFILE and linux
+    bool perfCounters;
+    // the asynchronous log is also written here, if set
+    string logFile;
+    // record the entity state FlightRecorder::RECORD_HZ times a second into a
+    // flightBufferMb ring, and write the last flightSeconds of it to flightFile on F, at
+    // exit, or on a crash
+    string flightFile;
+    float flightSeconds;
+    u32 flightBufferMb;
+    // the entities and bullets are published to this shared memory region every update,
+    // for out of process viewers, if set
+    string snapshotName;
+    // the rand() seed for the level, spawns and behaviors
+    u32 seed;
+    // the seed, config and input of the session are recorded to recordFile, or replayed
+    // from replayFile, if set. recording needs a window, and a headless replay runs as
+    // fast as the cpu allows
+    string recordFile;
+    string replayFile;
+    // a hash of the world state is written here after every physics tick, if set, and a
+    // hash per entity after every checksumEntityInterval'th tick, if that's non-zero
+    string checksumFile;
+    u32 checksumEntityInterval;
   };
 
-
   class Game
   {
   public:
     Game();
-    bool Init();
+    bool Init(const GameSettings& settings);
     bool Run();
     bool Close();
 
+    // the clock the game loop measures elapsed time with. defaults to the steady clock,
+    // and headless runs use a manual clock advanced one physics tick per update
+    void SetClock(Clock* clock) { _clock = clock; }
+
     void AddMessage(MessageType type, const string& str);
 
   private:
-    bool IsVisible(u32 x0, u32 y0, u32 x1, u32 y1);
-    void UpdateVisibility();
     void Render();
-    Vector2f GetEmptyPos();
-    Vector2f GetEmptyPos(const Vector2f& center, float radius);
     void DrawGrid();
     void DrawEntities();
-    void DrawBullets();
-    void UpdateBullets(float delta_s);
     void UpdateMessages();
     void Update();
+    bool RunHeadless();
 
-    void PhysicsUpdate(float delta_ms);
-
-    void SpawnEnemies();
-    void UpdateEnemies();
-    bool SpawnBullet(Entity& e);
+    void CreateLevelTexture();
+    void AttachDebugRenderers();
     void DebugDrawEntity();
 
-    Vector2f ClampedDestination(const Vector2f& pos, const Vector2f& dir);
-    Vector2f SnappedPos(const Vector2f& pos);
-
     bool OnLostFocus(const Event& event);
     bool OnGainedFocus(const Event& event);
     bool OnKeyPressed(const Event& event);
@@ -66,51 +104,76 @@ namespace pang
     bool OnMouseButtonReleased(const Event& event);
 
     void HandleInput();
-
-    Tile WorldToTile(const Vector2f& p) const;
-    Vector2f TileToWorld(u32 x, u32 y) const;
+    void ApplyKeys(u8 keys);
+    void ApplyEvent(InputEvent event);
+    void EndInputFrame();
+    bool ReplayFrame();
 
     struct Message
     {
       string str;
-      ptime endTime;
+      // in clock microseconds. 0 shows the message for a single frame
+      u64 endTimeUs;
       Color color;
     };
 
-    pang::config::Game _gameConfig;
+    GameSettings _settings;
+    Simulation _sim;
 
     unique_ptr<RenderWindow> _renderWindow;
     unique_ptr<WindowEventManager> _eventManager;
 
-    unordered_map<EntityId, shared_ptr<Entity> > _entities;
-    unordered_map<EntityId, shared_ptr<Entity> > _deadEntites;
-
-    Level _level;
+    Texture _levelTexture;
     Sprite _levelSprite;
     View _view;
 
-    shared_ptr<Entity> _selectedEntity;
+    // an entity's label, laid out once and redrawn until its handle index is reused
+    struct EntityLabel
+    {
+      EntityLabel() : id(NO_ENTITY), squadId(NO_SQUAD) {}
+      EntityId id;
+      SquadId squadId;
+      Text text;
+    };
+
+    // kept between frames, so drawing the level and entities doesn't allocate
+    vector<sf::Vertex> _gridVertices;
+    vector<sf::Vertex> _entityVertices;
+    // indexed by handle index
+    vector<EntityLabel> _entityLabels;
+    RectangleShape _playerRect;
+    RectangleShape _bulletRect;
+
+    // NO_ENTITY if no entity is selected
+    EntityId _selectedEntity;
+    unordered_map<EntityId, unique_ptr<DebugRenderer>> _debugRenderers;
 
-    vector<Bullet> _bullets;
     vector<Message> _messages;
+    // lines from the asynchronous log. debug lines are logged every frame, so only the
+    // lines from the newest frame are kept
+    vector<LogLine> _logLines;
+    vector<string> _debugLines;
+    u32 _debugFrame;
     Font _font;
-    u32 _gridSize;
     struct DebugDrawFlags {
-      enum Enum { EnemyInfo = 0x1, PlayerInfo = 0x2, BehaviorInfo = 0x4, PlayerCone = 0x8, DrawLevel = 0x10 };
-      struct Bits { u32 enemyInfo : 1; u32 playerInfo : 1; u32 behaviorInfo : 1; u32 playerCone : 1; u32 drawLevel : 1; };
+      enum Enum { EnemyInfo = 0x1, PlayerInfo = 0x2, BehaviorInfo = 0x4, PlayerCone = 0x8, DrawLevel = 0x10, CostInfo = 0x20 };
+      struct Bits { u32 enemyInfo : 1; u32 playerInfo : 1; u32 behaviorInfo : 1; u32 playerCone : 1; u32 drawLevel : 1; u32 costInfo : 1; };
     };
     Flags<DebugDrawFlags> _debugDraw;
     bool _focus;
     bool _done;
-    bool _playerDead;
-    bool _pausedEnemies;
-    ptime _now;
-    ptime _lastUpdate;
-
-    EntityId _localPlayerId;
+    SteadyClock _steadyClock;
+    ManualClock _manualClock;
+    Clock* _clock;
+    u64 _lastUpdate;
 
     u8 _prevLeft, _prevRight;
-    u64 _tickAcc;
+    // the input of the current update, and the recording it's written to, or replayed from
+    InputFrame _inputFrame;
+    InputFrame _replayFrame;
+    InputLog _inputLog;
+    bool _recording;
+    bool _replaying;
     Vector2i _windowSize;
     TwBar* _twBar;
   };
@@ -0,0 +1,116 @@
+#include "perf_counters.hpp"
+
+using namespace pang;
+
+namespace pang
+{
+  PerfCounters g_perfCounters;
+}
+
+//----------------------------------------------------------------------------------
+const char* pang::PerfEventName(PerfEvent event)
+{
+  switch (event)
+  {
+    case PerfEvent::Cycles: return "cycles";
+    case PerfEvent::Instructions: return "instructions";
+    case PerfEvent::CacheMisses: return "cache misses";
+    case PerfEvent::BranchMisses: return "branch misses";
+    default: return "unknown";
+  }
+}
+
+//----------------------------------------------------------------------------------
+PerfCounters::PerfCounters()
+{
+  for (int i = 0; i < NUM_EVENTS; ++i)
+    _fds[i] = -1;
+}
+
+//----------------------------------------------------------------------------------
+PerfCounters::~PerfCounters()
+{
+  Close();
+}
+
+//----------------------------------------------------------------------------------
+bool PerfCounters::Open()
+{
+#ifdef __linux__
+  if (IsOpen())
+    return true;
+
+  const u64 configs[NUM_EVENTS] =
+  {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+  };
+
+  for (int i = 0; i < NUM_EVENTS; ++i)
+  {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = configs[i];
+    attr.read_format = PERF_FORMAT_GROUP;
+    // user space only, which is allowed with the default perf_event_paranoid setting
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // the group is enabled once all the events are added
+    attr.disabled = i == 0;
+
+    // this thread, on any cpu. the cycles counter leads the group
+    int fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, _fds[0], 0);
+    if (fd == -1 && i == 0)
+    {
+      printf("perf_event_open failed (%s), using timers only\n", strerror(errno));
+      return false;
+    }
+    _fds[i] = fd;
+  }
+
+  ioctl(_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return true;
+#else
+  printf("hardware counters are only available on linux, using timers only\n");
+  return false;
+#endif
+}
+
+//----------------------------------------------------------------------------------
+void PerfCounters::Close()
+{
+#ifdef __linux__
+  for (int i = 0; i < NUM_EVENTS; ++i)
+  {
+    if (_fds[i] != -1)
+      close(_fds[i]);
+    _fds[i] = -1;
+  }
+#endif
+}
+
+//----------------------------------------------------------------------------------
+void PerfCounters::Read(u64* counts) const
+{
+  memset(counts, 0, NUM_EVENTS * sizeof(u64));
+
+#ifdef __linux__
+  // the group is read as the number of events, followed by the counts of the events that
+  // were opened, in order
+  u64 buf[1 + NUM_EVENTS];
+  if (read(_fds[0], buf, sizeof(buf)) <= 0)
+    return;
+
+  u64 idx = 0;
+  for (int i = 0; i < NUM_EVENTS && idx < buf[0]; ++i)
+  {
+    if (_fds[i] != -1)
+      counts[i] = buf[1 + idx++];
+  }
+#endif
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "types.hpp"
+
+namespace pang
+{
+  enum class PerfEvent
+  {
+    Cycles,
+    Instructions,
+    CacheMisses,
+    BranchMisses,
+    EventCount,
+  };
+
+  const char* PerfEventName(PerfEvent event);
+
+  // Hardware performance counters for the calling thread, read through linux
+  // perf_event_open as a single group. Open fails (and the profiler falls back to timers
+  // only) on other platforms, or when the kernel denies access. Events the cpu doesn't
+  // support are left out, and read as 0
+  struct PerfCounters
+  {
+    enum { NUM_EVENTS = (int)PerfEvent::EventCount };
+
+    PerfCounters();
+    ~PerfCounters();
+
+    bool Open();
+    void Close();
+    bool IsOpen() const { return _fds[0] != -1; }
+    bool HasEvent(PerfEvent event) const { return _fds[(int)event] != -1; }
+
+    // reads the running counts of all the events
+    void Read(u64* counts) const;
+
+  private:
+    int _fds[NUM_EVENTS];
+  };
+
+  extern PerfCounters g_perfCounters;
+}
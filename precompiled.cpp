@@ -1,6 +1 @@
 #include "precompiled.hpp"
-
-namespace pang
-{
-  const float PI = 3.1415926f;
-}
\ No newline at end of file
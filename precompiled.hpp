@@ -1,13 +1,17 @@
-#include <SFML/Graphics.hpp>
-#include <SFML/Window.hpp>
-#include <SFML/Network.hpp>
+#pragma once
+// The simulation core's precompiled header. The core only needs sfml-system, so the
+// graphics, window and tweak bar headers are in precompiled_game.hpp
+#include <SFML/System.hpp>
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <algorithm>
 #include <deque>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <ostream>
 #include <queue>
 #include <set>
@@ -18,32 +22,36 @@
 #include <thread>
 
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <stdio.h>
 
 #include <google/protobuf/text_format.h>
 
 #define BOOST_ALL_NO_LIB
-#include <boost/date_time/posix_time/posix_time_types.hpp>
-#include <boost/date_time.hpp>
 #include <boost/intrusive_ptr.hpp>
 #include <boost/array.hpp>
 
-#include <AntTweakBar.h>
-
 #ifdef _WIN32
 #include <windows.h>
 #include <direct.h>
 #include <io.h>
 #else
 #include <unistd.h>
-#include <CoreGraphics/CGDirectDisplay.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#include <sys/mman.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
 #endif
 
-#include <bristol/sfml/window_event_manager.hpp>
-#include <bristol/sfml/virtual_window_manager.hpp>
-#include <bristol/sfml/virtual_window.hpp>
 #include <bristol/sfml/sfml_math_utils.hpp>
-#include <bristol/sfml/sfml_helpers.hpp>
 #include <bristol/flags.hpp>
 #include <bristol/utils.hpp>
 #include <bristol/string_utils.hpp>
@@ -91,57 +99,18 @@ namespace pang
   using std::min;
   using std::max;
 
-  using sf::Color;
-  using sf::Font;
-  using sf::Text;
-  using sf::Image;
-  using sf::Texture;
-  using sf::Sprite;
-  using sf::CircleShape;
-  using sf::RectangleShape;
-  using sf::RenderTarget;
-  using sf::RenderWindow;
-  using sf::RenderTexture;
-  using sf::Keyboard;
-  using sf::Event;
-  using sf::View;
   using sf::Time;
-  using sf::Clock;
-  using sf::VertexArray;
 
   using sf::Vector2f;
   using sf::Vector2i;
   using sf::Vector2u;
-  using sf::IntRect;
-  using sf::FloatRect;
-  using sf::Transform;
-
-  using sf::IpAddress;
-  using sf::Socket;
-  using sf::TcpListener;
-  using sf::TcpSocket;
 
   using boost::intrusive_ptr;
-  using boost::posix_time::ptime;
-  using boost::posix_time::time_duration;
-  using boost::posix_time::microsec_clock;
-  using boost::posix_time::milliseconds;
-  using boost::posix_time::seconds;
   using boost::array;
 
-  using bristol::WindowEventManager;
-  using bristol::VirtualWindowManager;
-  using bristol::GridSplitter;
-  using bristol::VirtualWindow;
   using bristol::Flags;
 
   using bristol::exch_null;
   using bristol::randf;
 
 }
-
-#ifdef _DEBUG
-#pragma comment(lib, "libboost_date_time-vc120-mt-sgd-1_55.lib")
-#else
-#pragma comment(lib, "libboost_date_time-vc120-mt-s-1_55.lib")
-#endif
@@ -0,0 +1 @@
+#include "precompiled_game.hpp"
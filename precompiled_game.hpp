@@ -0,0 +1,51 @@
+#pragma once
+// The game's precompiled header: the core's, plus sfml-graphics/window and the tweak bar
+#include "precompiled.hpp"
+
+#include <SFML/Graphics.hpp>
+#include <SFML/Window.hpp>
+#include <SFML/Network.hpp>
+
+#include <AntTweakBar.h>
+
+#ifdef __APPLE__
+#include <CoreGraphics/CGDirectDisplay.h>
+#endif
+
+#include <bristol/sfml/window_event_manager.hpp>
+#include <bristol/sfml/virtual_window_manager.hpp>
+#include <bristol/sfml/virtual_window.hpp>
+#include <bristol/sfml/sfml_helpers.hpp>
+
+namespace pang
+{
+  using sf::Color;
+  using sf::Font;
+  using sf::Text;
+  using sf::Image;
+  using sf::Texture;
+  using sf::Sprite;
+  using sf::CircleShape;
+  using sf::RectangleShape;
+  using sf::RenderTarget;
+  using sf::RenderWindow;
+  using sf::RenderTexture;
+  using sf::Keyboard;
+  using sf::Event;
+  using sf::View;
+  using sf::VertexArray;
+
+  using sf::IntRect;
+  using sf::FloatRect;
+  using sf::Transform;
+
+  using sf::IpAddress;
+  using sf::Socket;
+  using sf::TcpListener;
+  using sf::TcpSocket;
+
+  using bristol::WindowEventManager;
+  using bristol::VirtualWindowManager;
+  using bristol::GridSplitter;
+  using bristol::VirtualWindow;
+}
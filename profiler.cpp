@@ -0,0 +1,571 @@
+#include "profiler.hpp"
+
+using namespace pang;
+
+namespace pang
+{
+  FrameProfiler g_frameProfiler;
+  CostAttribution g_costAttribution;
+  thread_local Phase t_curPhase = Phase::PhaseCount;
+}
+
+//----------------------------------------------------------------------------------
+const char* pang::PhaseName(Phase phase)
+{
+  switch (phase)
+  {
+    case Phase::HandleInput: return "HandleInput";
+    case Phase::Physics: return "Physics";
+    case Phase::Visibility: return "Visibility";
+    case Phase::Bullets: return "Bullets";
+    case Phase::Coordinator: return "Coordinator";
+    case Phase::Enemies: return "Enemies";
+    case Phase::SpatialSort: return "SpatialSort";
+    case Phase::DrawGrid: return "DrawGrid";
+    case Phase::DrawEntities: return "DrawEntities";
+    case Phase::UpdateMessages: return "UpdateMessages";
+    default: return "Unknown";
+  }
+}
+
+//----------------------------------------------------------------------------------
+const char* pang::CounterName(Counter counter)
+{
+  switch (counter)
+  {
+    case Counter::PhysicsTicks: return "physics ticks";
+    case Counter::Entities: return "entities";
+    case Counter::VisibilityChecks: return "visibility checks";
+    case Counter::Bullets: return "bullets";
+    default: return "unknown";
+  }
+}
+
+//----------------------------------------------------------------------------------
+const char* pang::CostKindName(CostKind kind)
+{
+  switch (kind)
+  {
+    case CostKind::Arrive: return "Arrive";
+    case CostKind::AvoidWall: return "AvoidWall";
+    case CostKind::Wander: return "Wander";
+    case CostKind::Pursuit: return "Pursuit";
+    case CostKind::Visibility: return "Visibility";
+    default: return "Unknown";
+  }
+}
+
+//----------------------------------------------------------------------------------
+LatencyHistogram::LatencyHistogram()
+    : _count(0)
+    , _max(0)
+{
+  memset(_buckets, 0, sizeof(_buckets));
+}
+
+//----------------------------------------------------------------------------------
+u32 LatencyHistogram::BucketIdx(u64 ns)
+{
+  if (ns < NUM_SUB)
+    return (u32)ns;
+
+  u32 msb = 0;
+  while (ns >> (msb + 1))
+    ++msb;
+
+  // the top SUB_BITS bits below the msb select the linear bucket
+  u32 shift = msb - SUB_BITS;
+  return ((shift + 1) << SUB_BITS) + (u32)((ns >> shift) & (NUM_SUB - 1));
+}
+
+//----------------------------------------------------------------------------------
+u64 LatencyHistogram::BucketUpperBound(u32 idx)
+{
+  if (idx < NUM_SUB)
+    return idx;
+
+  u32 shift = (idx >> SUB_BITS) - 1;
+  u64 mantissa = NUM_SUB + (idx & (NUM_SUB - 1));
+  return ((mantissa + 1) << shift) - 1;
+}
+
+//----------------------------------------------------------------------------------
+void LatencyHistogram::Add(u64 ns)
+{
+  _buckets[BucketIdx(ns)]++;
+  _count++;
+  _max = max(_max, ns);
+}
+
+//----------------------------------------------------------------------------------
+u64 LatencyHistogram::Percentile(double p) const
+{
+  if (_count == 0)
+    return 0;
+
+  u64 rank = (u64)ceil(p / 100 * _count);
+  u64 acc = 0;
+  for (u32 i = 0; i < NUM_BUCKETS; ++i)
+  {
+    acc += _buckets[i];
+    if (acc >= rank)
+      return min(BucketUpperBound(i), _max);
+  }
+  return _max;
+}
+
+//----------------------------------------------------------------------------------
+FrameProfiler::FrameProfiler()
+    : _avgFrameMs(0)
+    , _frameAllocs(0)
+    , _frameStart(0)
+    , _frame(0)
+    , _csv(nullptr)
+    , _hitchBudgetNs((u64)(1e9 / 30))
+    , _numHitches(0)
+    , _allocWarmupFrames(0)
+    , _numAllocFrames(0)
+    , _allocCheck(false)
+    , _allocCheckFatal(false)
+{
+  memset(_avgMs, 0, sizeof(_avgMs));
+  memset(_cur, 0, sizeof(_cur));
+  memset(_counters, 0, sizeof(_counters));
+  memset(_history, 0, sizeof(_history));
+  memset(_sum, 0, sizeof(_sum));
+  memset(_ipc, 0, sizeof(_ipc));
+  memset(_totalNs, 0, sizeof(_totalNs));
+  memset(_perfCur, 0, sizeof(_perfCur));
+  memset(_perfTotal, 0, sizeof(_perfTotal));
+  memset(_totalAllocs, 0, sizeof(_totalAllocs));
+  memset(_totalAllocBytes, 0, sizeof(_totalAllocBytes));
+  for (int i = 0; i < NUM_ALLOC_SLOTS; ++i)
+  {
+    _allocs[i] = 0;
+    _allocBytes[i] = 0;
+  }
+}
+
+//----------------------------------------------------------------------------------
+FrameProfiler::~FrameProfiler()
+{
+  Close();
+}
+
+//----------------------------------------------------------------------------------
+bool FrameProfiler::OpenCsv(const string& filename)
+{
+  Close();
+  _csv = fopen(filename.c_str(), "w");
+  if (!_csv)
+    return false;
+
+  fprintf(_csv, "frame,frame_ms");
+  for (int i = 0; i < NUM_PHASES; ++i)
+    fprintf(_csv, ",%s_ms", PhaseName((Phase)i));
+  fprintf(_csv, ",allocs,alloc_bytes\n");
+  return true;
+}
+
+//----------------------------------------------------------------------------------
+void FrameProfiler::Close()
+{
+  if (_csv)
+  {
+    fclose(_csv);
+    _csv = nullptr;
+  }
+}
+
+//----------------------------------------------------------------------------------
+void FrameProfiler::BeginFrame()
+{
+  memset(_cur, 0, sizeof(_cur));
+  memset(_counters, 0, sizeof(_counters));
+  memset(_perfCur, 0, sizeof(_perfCur));
+  for (int i = 0; i < NUM_ALLOC_SLOTS; ++i)
+  {
+    _allocs[i].store(0, std::memory_order_relaxed);
+    _allocBytes[i].store(0, std::memory_order_relaxed);
+  }
+  _frameStart = NowNs();
+}
+
+//----------------------------------------------------------------------------------
+void FrameProfiler::AddPerf(Phase phase, const u64* start, const u64* end)
+{
+  u64* cur = _perfCur[(int)phase];
+  for (int i = 0; i < NUM_PERF_EVENTS; ++i)
+    cur[i] += end[i] - start[i];
+}
+
+//----------------------------------------------------------------------------------
+void FrameProfiler::AddAlloc(size_t bytes)
+{
+  int slot = (int)t_curPhase;
+  _allocs[slot].fetch_add(1, std::memory_order_relaxed);
+  _allocBytes[slot].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------------
+void FrameProfiler::SetAllocCheck(u32 warmupFrames, bool fatal)
+{
+  _allocCheck = true;
+  _allocWarmupFrames = warmupFrames;
+  _allocCheckFatal = fatal;
+}
+
+//----------------------------------------------------------------------------------
+void FrameProfiler::AddTick(u64 ns)
+{
+  _tickTimes.Add(ns);
+  _counters[(int)Counter::PhysicsTicks]++;
+}
+
+//----------------------------------------------------------------------------------
+void FrameProfiler::EndFrame()
+{
+  u64 frameNs = NowNs() - _frameStart;
+
+  // replace the oldest frame in the rolling window
+  u64* slot = _history[_frame % NUM_FRAMES];
+  for (int i = 0; i < NUM_PHASES; ++i)
+  {
+    _sum[i] += _cur[i] - slot[i];
+    slot[i] = _cur[i];
+  }
+  _sum[NUM_PHASES] += frameNs - slot[NUM_PHASES];
+  slot[NUM_PHASES] = frameNs;
+
+  for (int i = 0; i < NUM_PHASES; ++i)
+  {
+    _totalNs[i] += _cur[i];
+    u64* perf = _perfCur[i];
+    for (int j = 0; j < NUM_PERF_EVENTS; ++j)
+      _perfTotal[i][j] += perf[j];
+
+    u64 cycles = perf[(int)PerfEvent::Cycles];
+    if (cycles)
+      _ipc[i] = (float)perf[(int)PerfEvent::Instructions] / cycles;
+  }
+
+  ++_frame;
+  float scale = 1e-6f / min<u32>(_frame, NUM_FRAMES);
+  for (int i = 0; i < NUM_PHASES; ++i)
+    _avgMs[i] = _sum[i] * scale;
+  _avgFrameMs = _sum[NUM_PHASES] * scale;
+
+  // snapshot the allocation counts before the reporting below allocates anything
+  u32 allocs[NUM_ALLOC_SLOTS];
+  u64 allocBytes[NUM_ALLOC_SLOTS];
+  u32 phaseAllocs = 0;
+  u64 frameAllocBytes = 0;
+  for (int i = 0; i < NUM_ALLOC_SLOTS; ++i)
+  {
+    allocs[i] = _allocs[i].load(std::memory_order_relaxed);
+    allocBytes[i] = _allocBytes[i].load(std::memory_order_relaxed);
+    _totalAllocs[i] += allocs[i];
+    _totalAllocBytes[i] += allocBytes[i];
+    frameAllocBytes += allocBytes[i];
+    if (i < NUM_PHASES)
+      phaseAllocs += allocs[i];
+  }
+  _frameAllocs = phaseAllocs + allocs[NUM_PHASES];
+  // the message overlay copies in messages as they're logged, so it isn't checked
+  u32 checkedAllocs = phaseAllocs - allocs[(int)Phase::UpdateMessages];
+
+  if (_csv)
+  {
+    fprintf(_csv, "%u,%.4f", _frame, frameNs / 1e6);
+    for (int i = 0; i < NUM_PHASES; ++i)
+      fprintf(_csv, ",%.4f", _cur[i] / 1e6);
+    fprintf(_csv, ",%u,%llu\n", _frameAllocs, (unsigned long long)frameAllocBytes);
+  }
+
+  if (_allocCheck && _frame > _allocWarmupFrames && checkedAllocs > 0)
+  {
+    if (++_numAllocFrames <= MAX_ALLOC_REPORTS || _allocCheckFatal)
+    {
+      printf("alloc: frame %u made %u allocations in steady state:", _frame, checkedAllocs);
+      for (int i = 0; i < NUM_PHASES; ++i)
+      {
+        if (allocs[i] && i != (int)Phase::UpdateMessages)
+          printf(" %s: %u (%llu bytes)", PhaseName((Phase)i), allocs[i], (unsigned long long)allocBytes[i]);
+      }
+      printf("\n");
+    }
+
+    if (_allocCheckFatal)
+    {
+      fflush(stdout);
+      abort();
+    }
+  }
+
+  _frameTimes.Add(frameNs);
+
+  if (_hitchBudgetNs && frameNs > _hitchBudgetNs)
+  {
+    ++_numHitches;
+    printf("hitch: frame %u took %.2f ms (budget %.2f ms):", _frame, frameNs / 1e6, _hitchBudgetNs / 1e6);
+    for (int i = 0; i < NUM_COUNTERS; ++i)
+      printf("%s %u %s", i == 0 ? "" : ",", _counters[i], CounterName((Counter)i));
+    printf("\n ");
+    for (int i = 0; i < NUM_PHASES; ++i)
+    {
+      if (_cur[i])
+        printf(" %s: %.2f ms", PhaseName((Phase)i), _cur[i] / 1e6);
+    }
+    printf("\n");
+  }
+}
+
+//----------------------------------------------------------------------------------
+void FrameProfiler::PrintSummary() const
+{
+  if (_frameTimes.Count() == 0)
+    return;
+
+  const auto& fnPrint = [](const char* name, const LatencyHistogram& h)
+  {
+    printf("%-6s %8llu  p50: %7.3f  p95: %7.3f  p99: %7.3f  p99.9: %7.3f  max: %7.3f ms\n",
+        name, (unsigned long long)h.Count(),
+        h.Percentile(50) / 1e6, h.Percentile(95) / 1e6, h.Percentile(99) / 1e6,
+        h.Percentile(99.9) / 1e6, h.Max() / 1e6);
+  };
+
+  fnPrint("frame", _frameTimes);
+  fnPrint("tick", _tickTimes);
+  printf("%u frames over the %.2f ms hitch budget\n", _numHitches, _hitchBudgetNs / 1e6);
+
+  if (g_perfCounters.IsOpen())
+  {
+    // misses are per 1000 instructions
+    printf("%-16s %10s %14s %8s %14s %14s\n", "phase", "ms/frame", "cycles/frame", "ipc", "cache miss/ki", "branch miss/ki");
+    double frameScale = 1.0 / _frameTimes.Count();
+    for (int i = 0; i < NUM_PHASES; ++i)
+    {
+      const u64* perf = _perfTotal[i];
+      u64 cycles = perf[(int)PerfEvent::Cycles];
+      u64 instructions = perf[(int)PerfEvent::Instructions];
+      if (!cycles)
+        continue;
+
+      printf("%-16s %10.3f %14.0f %8.2f", PhaseName((Phase)i), _totalNs[i] * frameScale / 1e6,
+          cycles * frameScale, instructions ? (double)instructions / cycles : 0.0);
+      for (PerfEvent e : { PerfEvent::CacheMisses, PerfEvent::BranchMisses })
+      {
+        if (g_perfCounters.HasEvent(e) && instructions)
+          printf(" %14.2f", 1000.0 * perf[(int)e] / instructions);
+        else
+          printf(" %14s", "-");
+      }
+      printf("\n");
+    }
+  }
+
+  printf("allocs/frame:");
+  double scale = 1.0 / _frameTimes.Count();
+  for (int i = 0; i < NUM_ALLOC_SLOTS; ++i)
+  {
+    if (_totalAllocs[i])
+    {
+      printf(" %s: %.1f (%.0f bytes)", i < NUM_PHASES ? PhaseName((Phase)i) : "Other",
+          _totalAllocs[i] * scale, _totalAllocBytes[i] * scale);
+    }
+  }
+  printf("\n");
+
+  if (_allocCheck)
+    printf("%u frames allocated after the %u frame warmup\n", _numAllocFrames, _allocWarmupFrames);
+}
+
+//----------------------------------------------------------------------------------
+CostAttribution::Costs::Costs()
+{
+  Reset();
+}
+
+//----------------------------------------------------------------------------------
+void CostAttribution::Costs::Reset()
+{
+  // keep the squad slots, so a steady state doesn't allocate
+  std::fill(squadNs.begin(), squadNs.end(), 0);
+  playerNs = 0;
+  memset(kindNs, 0, sizeof(kindNs));
+  numSamples = 0;
+}
+
+//----------------------------------------------------------------------------------
+CostAttribution::CostAttribution()
+    : _numUpdates(0)
+    , _sampling(false)
+{
+}
+
+//----------------------------------------------------------------------------------
+void CostAttribution::BeginUpdate()
+{
+  _sampling = _numUpdates++ % SAMPLE_INTERVAL == 0;
+  if (!_sampling)
+    return;
+
+  if (_window.numSamples == WINDOW_SAMPLES)
+  {
+    std::swap(_lastWindow, _window);
+    _window.Reset();
+  }
+
+  _total.numSamples++;
+  _window.numSamples++;
+}
+
+//----------------------------------------------------------------------------------
+void CostAttribution::SetNumSquads(u32 numSquads)
+{
+  for (Costs* c : { &_total, &_window, &_lastWindow })
+  {
+    if (numSquads > c->squadNs.size())
+      c->squadNs.resize(numSquads);
+  }
+}
+
+//----------------------------------------------------------------------------------
+void CostAttribution::Add(CostKind kind, SquadId squad, u64 ns)
+{
+  for (Costs* c : { &_total, &_window })
+  {
+    c->kindNs[(int)kind] += ns;
+    if (squad == NO_SQUAD)
+      c->playerNs += ns;
+    else if (squad < c->squadNs.size())
+      c->squadNs[squad] += ns;
+  }
+}
+
+//----------------------------------------------------------------------------------
+void CostAttribution::TopSquads(bool recent, u32 n, vector<pair<SquadId, float>>* squads) const
+{
+  const Costs& c = recent ? Recent() : _total;
+  squads->clear();
+  if (c.numSamples == 0)
+    return;
+
+  float scale = 1e-3f / c.numSamples;
+  for (size_t i = 0; i < c.squadNs.size(); ++i)
+  {
+    if (c.squadNs[i])
+      squads->push_back(make_pair((SquadId)i, c.squadNs[i] * scale));
+  }
+  if (c.playerNs)
+    squads->push_back(make_pair(NO_SQUAD, c.playerNs * scale));
+
+  const auto& fnCmp = [](const pair<SquadId, float>& lhs, const pair<SquadId, float>& rhs) { return lhs.second > rhs.second; };
+  n = min(n, (u32)squads->size());
+  std::partial_sort(squads->begin(), squads->begin() + n, squads->end(), fnCmp);
+  squads->resize(n);
+}
+
+//----------------------------------------------------------------------------------
+void CostAttribution::TopKinds(bool recent, u32 n, vector<pair<CostKind, float>>* kinds) const
+{
+  const Costs& c = recent ? Recent() : _total;
+  kinds->clear();
+  if (c.numSamples == 0)
+    return;
+
+  float scale = 1e-3f / c.numSamples;
+  for (int i = 0; i < NUM_KINDS; ++i)
+  {
+    if (c.kindNs[i])
+      kinds->push_back(make_pair((CostKind)i, c.kindNs[i] * scale));
+  }
+
+  const auto& fnCmp = [](const pair<CostKind, float>& lhs, const pair<CostKind, float>& rhs) { return lhs.second > rhs.second; };
+  std::sort(kinds->begin(), kinds->end(), fnCmp);
+  if (kinds->size() > n)
+    kinds->resize(n);
+}
+
+//----------------------------------------------------------------------------------
+void CostAttribution::PrintSummary(u32 n) const
+{
+  if (_total.numSamples == 0)
+    return;
+
+  vector<pair<CostKind, float>> kinds;
+  TopKinds(false, n, &kinds);
+  printf("cost per sampled update (%u samples):", _total.numSamples);
+  for (const auto& k : kinds)
+    printf(" %s: %.1f us", CostKindName(k.first), k.second);
+  printf("\n");
+
+  vector<pair<SquadId, float>> squads;
+  TopSquads(false, n, &squads);
+  printf("top %u squads:", n);
+  for (const auto& s : squads)
+  {
+    if (s.first == NO_SQUAD)
+      printf(" player: %.1f us", s.second);
+    else
+      printf(" %u: %.1f us", s.first, s.second);
+  }
+  printf("\n");
+}
+
+#ifdef PANG_PROFILE
+// Replacement global allocation functions, so every heap allocation is counted against
+// the current phase. The array and nothrow forms forward to the plain ones
+//----------------------------------------------------------------------------------
+void* operator new(size_t size)
+{
+  g_frameProfiler.AddAlloc(size);
+  void* p = malloc(size ? size : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+//----------------------------------------------------------------------------------
+void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+//----------------------------------------------------------------------------------
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+  g_frameProfiler.AddAlloc(size);
+  return malloc(size ? size : 1);
+}
+
+//----------------------------------------------------------------------------------
+void* operator new[](size_t size, const std::nothrow_t& nt) noexcept
+{
+  return operator new(size, nt);
+}
+
+//----------------------------------------------------------------------------------
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+//----------------------------------------------------------------------------------
+void operator delete[](void* p) noexcept
+{
+  free(p);
+}
+
+//----------------------------------------------------------------------------------
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+  free(p);
+}
+
+//----------------------------------------------------------------------------------
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+  free(p);
+}
+#endif
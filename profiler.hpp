@@ -0,0 +1,273 @@
+#pragma once
+#include "types.hpp"
+#include "trace.hpp"
+#include "perf_counters.hpp"
+
+namespace pang
+{
+  enum class Phase
+  {
+    HandleInput,
+    Physics,
+    Visibility,
+    Bullets,
+    Coordinator,
+    Enemies,
+    SpatialSort,
+    DrawGrid,
+    DrawEntities,
+    UpdateMessages,
+    PhaseCount,
+  };
+
+  const char* PhaseName(Phase phase);
+
+  // per-frame counters, reported when a frame goes over budget
+  enum class Counter
+  {
+    PhysicsTicks,
+    Entities,
+    VisibilityChecks,
+    Bullets,
+    CounterCount,
+  };
+
+  const char* CounterName(Counter counter);
+
+  // Log-linear histogram of durations in ns, with 16 linear buckets per power of two
+  // (so percentiles are accurate to about 6%)
+  struct LatencyHistogram
+  {
+    enum { SUB_BITS = 4, NUM_SUB = 1 << SUB_BITS, NUM_BUCKETS = 64 * NUM_SUB };
+
+    LatencyHistogram();
+    void Add(u64 ns);
+    u64 Percentile(double p) const;
+    u64 Count() const { return _count; }
+    u64 Max() const { return _max; }
+
+  private:
+    static u32 BucketIdx(u64 ns);
+    static u64 BucketUpperBound(u32 idx);
+
+    u64 _buckets[NUM_BUCKETS];
+    u64 _count;
+    u64 _max;
+  };
+
+  // the innermost phase open on this thread (PhaseCount outside of any phase). heap
+  // allocations are attributed to it
+  extern thread_local Phase t_curPhase;
+
+  // Accumulates the time spent in each phase over a frame, keeps rolling averages over the
+  // last NUM_FRAMES frames, and optionally writes a csv row per frame. Frame and physics
+  // tick durations are also kept in histograms, and frames over the hitch budget get their
+  // breakdown dumped.
+  // Heap allocations are counted per phase, and after a warmup any frame that allocates
+  // inside a phase other than UpdateMessages can be reported. If g_perfCounters is open, the hardware counters are
+  // also accumulated per phase
+  struct FrameProfiler
+  {
+    enum { NUM_PHASES = (int)Phase::PhaseCount, NUM_COUNTERS = (int)Counter::CounterCount, NUM_FRAMES = 64 };
+    enum { NUM_PERF_EVENTS = PerfCounters::NUM_EVENTS };
+    // allocations outside of any phase go in the extra slot
+    enum { NUM_ALLOC_SLOTS = NUM_PHASES + 1, MAX_ALLOC_REPORTS = 16 };
+
+    FrameProfiler();
+    ~FrameProfiler();
+
+    bool OpenCsv(const string& filename);
+    void Close();
+
+    void BeginFrame();
+    void EndFrame();
+    void AddTime(Phase phase, u64 ns) { _cur[(int)phase] += ns; }
+    void AddTick(u64 ns);
+    void AddCount(Counter counter, u32 n) { _counters[(int)counter] += n; }
+    void AddPerf(Phase phase, const u64* start, const u64* end);
+
+    // called by the replacement operator new, from any thread
+    void AddAlloc(size_t bytes);
+    // frames after warmupFrames that allocate inside a phase are reported, or abort if fatal
+    void SetAllocCheck(u32 warmupFrames, bool fatal);
+
+    void SetHitchBudget(float ms) { _hitchBudgetNs = (u64)(ms * 1e6); }
+    void PrintSummary() const;
+
+    // rolling averages, in ms. these are exposed directly to the tweak bar
+    float _avgMs[NUM_PHASES];
+    float _avgFrameMs;
+    u32 _frameAllocs;
+    // instructions per cycle in the last frame, when the hardware counters are open
+    float _ipc[NUM_PHASES];
+
+  private:
+    u64 _cur[NUM_PHASES];
+    u64 _history[NUM_FRAMES][NUM_PHASES + 1];
+    u64 _sum[NUM_PHASES + 1];
+    u32 _counters[NUM_COUNTERS];
+    u64 _frameStart;
+    u32 _frame;
+    FILE* _csv;
+
+    u64 _totalNs[NUM_PHASES];
+    u64 _perfCur[NUM_PHASES][NUM_PERF_EVENTS];
+    u64 _perfTotal[NUM_PHASES][NUM_PERF_EVENTS];
+
+    LatencyHistogram _frameTimes;
+    LatencyHistogram _tickTimes;
+    u64 _hitchBudgetNs;
+    u32 _numHitches;
+
+    atomic<u32> _allocs[NUM_ALLOC_SLOTS];
+    atomic<u64> _allocBytes[NUM_ALLOC_SLOTS];
+    u64 _totalAllocs[NUM_ALLOC_SLOTS];
+    u64 _totalAllocBytes[NUM_ALLOC_SLOTS];
+    u32 _allocWarmupFrames;
+    u32 _numAllocFrames;
+    bool _allocCheck;
+    bool _allocCheckFatal;
+  };
+
+  extern FrameProfiler g_frameProfiler;
+
+  struct ScopedPhase
+  {
+    ScopedPhase(Phase phase) : _phase(phase), _prevPhase(t_curPhase)
+    {
+      t_curPhase = phase;
+      if (g_perfCounters.IsOpen())
+        g_perfCounters.Read(_perfStart);
+      _start = NowNs();
+    }
+
+    ~ScopedPhase()
+    {
+      u64 duration = NowNs() - _start;
+      g_frameProfiler.AddTime(_phase, duration);
+      if (g_perfCounters.IsOpen())
+      {
+        u64 perfEnd[PerfCounters::NUM_EVENTS];
+        g_perfCounters.Read(perfEnd);
+        g_frameProfiler.AddPerf(_phase, _perfStart, perfEnd);
+      }
+      if (g_traceRecorder.IsRecording())
+        g_traceRecorder.AddEvent(PhaseName(_phase), _start, duration);
+      t_curPhase = _prevPhase;
+    }
+    Phase _phase;
+    Phase _prevPhase;
+    u64 _start;
+    u64 _perfStart[PerfCounters::NUM_EVENTS];
+  };
+
+  struct ScopedTick
+  {
+    ScopedTick() : _start(NowNs()) {}
+    ~ScopedTick() { g_frameProfiler.AddTick(NowNs() - _start); }
+    u64 _start;
+  };
+
+  // the per-entity work that gets attributed to squads
+  enum class CostKind
+  {
+    Arrive,
+    AvoidWall,
+    Wander,
+    Pursuit,
+    Visibility,
+    CostKindCount,
+  };
+
+  const char* CostKindName(CostKind kind);
+
+  // Sampled cost attribution. One simulation update in every SAMPLE_INTERVAL is timed, and
+  // the time spent in each behavior and in each entity's visibility loop is summed per
+  // CostKind and per squad. Costs are kept for the whole run, and for the last window of
+  // WINDOW_SAMPLES samples (which the overlay shows)
+  struct CostAttribution
+  {
+    enum { NUM_KINDS = (int)CostKind::CostKindCount, SAMPLE_INTERVAL = 8, WINDOW_SAMPLES = 32 };
+
+    CostAttribution();
+
+    void BeginUpdate();
+    bool IsSampling() const { return _sampling; }
+    // makes room for squad ids below numSquads. called when squad ids are handed out, so
+    // the sampled updates never allocate. costs for squads without room are dropped
+    void SetNumSquads(u32 numSquads);
+    void Add(CostKind kind, SquadId squad, u64 ns);
+
+    // the n costliest squads and kinds, in us per sampled update. NO_SQUAD is the player
+    void TopSquads(bool recent, u32 n, vector<pair<SquadId, float>>* squads) const;
+    void TopKinds(bool recent, u32 n, vector<pair<CostKind, float>>* kinds) const;
+    void PrintSummary(u32 n) const;
+
+  private:
+    struct Costs
+    {
+      Costs();
+      void Reset();
+      vector<u64> squadNs;
+      u64 playerNs;
+      u64 kindNs[NUM_KINDS];
+      u32 numSamples;
+    };
+
+    const Costs& Recent() const { return _lastWindow.numSamples ? _lastWindow : _window; }
+
+    Costs _total;
+    Costs _window;
+    Costs _lastWindow;
+    u32 _numUpdates;
+    bool _sampling;
+  };
+
+  extern CostAttribution g_costAttribution;
+
+  struct ScopedCost
+  {
+    ScopedCost(CostKind kind, SquadId squad)
+      : _kind(kind), _squad(squad), _start(g_costAttribution.IsSampling() ? NowNs() : 0) {}
+    ~ScopedCost()
+    {
+      if (_start)
+        g_costAttribution.Add(_kind, _squad, NowNs() - _start);
+    }
+    CostKind _kind;
+    SquadId _squad;
+    u64 _start;
+  };
+
+  // only tracks the current phase, for the phase timers' stand in when they're compiled
+  // out, so the sampler can still split its samples by phase
+  struct ScopedPhaseTag
+  {
+    ScopedPhaseTag(Phase phase) : _prevPhase(t_curPhase) { t_curPhase = phase; }
+    ~ScopedPhaseTag() { t_curPhase = _prevPhase; }
+    Phase _prevPhase;
+  };
+
+  // the phase timers are compiled out unless PANG_PROFILE is defined, but the phases
+  // are always available to the trace recorder and the sampler
+#ifdef PANG_PROFILE
+#define PROFILE_PHASE(phase) pang::ScopedPhase PROFILE_CONCAT(scopedPhase, __LINE__)(pang::Phase::phase)
+#define PROFILE_BEGIN_FRAME() pang::g_frameProfiler.BeginFrame()
+#define PROFILE_END_FRAME() pang::g_frameProfiler.EndFrame()
+#define PROFILE_TICK() pang::ScopedTick PROFILE_CONCAT(scopedTick, __LINE__)
+#define PROFILE_COUNT(counter, n) pang::g_frameProfiler.AddCount(pang::Counter::counter, (u32)(n))
+#define PROFILE_COST_UPDATE() pang::g_costAttribution.BeginUpdate()
+#define PROFILE_COST(kind, squad) pang::ScopedCost PROFILE_CONCAT(scopedCost, __LINE__)(pang::CostKind::kind, squad)
+#define PROFILE_COST_SQUADS(n) pang::g_costAttribution.SetNumSquads((u32)(n))
+#else
+#define PROFILE_PHASE(phase) TRACE_SCOPE(#phase); \
+  pang::ScopedPhaseTag PROFILE_CONCAT(scopedPhaseTag, __LINE__)(pang::Phase::phase)
+#define PROFILE_BEGIN_FRAME()
+#define PROFILE_END_FRAME()
+#define PROFILE_TICK()
+#define PROFILE_COUNT(counter, n)
+#define PROFILE_COST_UPDATE()
+#define PROFILE_COST(kind, squad)
+#define PROFILE_COST_SQUADS(n)
+#endif
+}
@@ -35,13 +35,19 @@ void protobuf_AssignDesc_game_2eproto() {
       "game.proto");
   GOOGLE_CHECK(file != NULL);
   Game_descriptor_ = file->message_type(0);
-  static const int Game_offsets_[6] = {
+  static const int Game_offsets_[12] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Game, width_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Game, height_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Game, num_squads_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Game, mobs_per_squad_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Game, num_walls_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Game, max_wall_size_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Game, physics_hz_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Game, perception_hz_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Game, ai_hz_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Game, bullets_hz_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Game, spatial_sort_hz_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(Game, spatial_sort_drift_),
   };
   Game_reflection_ =
     new ::google::protobuf::internal::GeneratedMessageReflection(
@@ -84,10 +90,14 @@ void protobuf_AddDesc_game_2eproto() {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
   ::google::protobuf::DescriptorPool::InternalAddGeneratedFile(
-    "\n\ngame.proto\022\013pang.config\"{\n\004Game\022\r\n\005wid"
-    "th\030\001 \001(\005\022\016\n\006height\030\002 \001(\005\022\022\n\nnum_squads\030\003"
-    " \001(\005\022\026\n\016mobs_per_squad\030\004 \001(\005\022\021\n\tnum_wall"
-    "s\030\005 \001(\005\022\025\n\rmax_wall_size\030\006 \001(\002", 150);
+    "\n\ngame.proto\022\013pang.config\"\231\002\n\004Game\022\r\n\005wi"
+    "dth\030\001 \001(\005\022\016\n\006height\030\002 \001(\005\022\022\n\nnum_squads\030"
+    "\003 \001(\005\022\026\n\016mobs_per_squad\030\004 \001(\005\022\021\n\tnum_wal"
+    "ls\030\005 \001(\005\022\025\n\rmax_wall_size\030\006 \001(\002\022\027\n\nphysi"
+    "cs_hz\030\007 \001(\005:\003100\022\031\n\rperception_hz\030\010 \001(\005:"
+    "\00210\022\021\n\005ai_hz\030\t \001(\005:\00220\022\027\n\nbullets_hz\030\n \001"
+    "(\005:\003100\022\032\n\017spatial_sort_hz\030\013 \001(\005:\0011\022 \n\022s"
+    "patial_sort_drift\030\014 \001(\002:\0040.25", 309);
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedFile(
     "game.proto", &protobuf_RegisterTypes);
   Game::default_instance_ = new Game();
@@ -111,6 +121,12 @@ const int Game::kNumSquadsFieldNumber;
 const int Game::kMobsPerSquadFieldNumber;
 const int Game::kNumWallsFieldNumber;
 const int Game::kMaxWallSizeFieldNumber;
+const int Game::kPhysicsHzFieldNumber;
+const int Game::kPerceptionHzFieldNumber;
+const int Game::kAiHzFieldNumber;
+const int Game::kBulletsHzFieldNumber;
+const int Game::kSpatialSortHzFieldNumber;
+const int Game::kSpatialSortDriftFieldNumber;
 #endif  // !_MSC_VER
 
 Game::Game()
@@ -135,6 +151,12 @@ void Game::SharedCtor() {
   mobs_per_squad_ = 0;
   num_walls_ = 0;
   max_wall_size_ = 0;
+  physics_hz_ = 100;
+  perception_hz_ = 10;
+  ai_hz_ = 20;
+  bullets_hz_ = 100;
+  spatial_sort_hz_ = 1;
+  spatial_sort_drift_ = 0.25f;
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -176,6 +198,14 @@ void Game::Clear() {
     mobs_per_squad_ = 0;
     num_walls_ = 0;
     max_wall_size_ = 0;
+    physics_hz_ = 100;
+    perception_hz_ = 10;
+  }
+  if (_has_bits_[8 / 32] & (0xffu << (8 % 32))) {
+    ai_hz_ = 20;
+    bullets_hz_ = 100;
+    spatial_sort_hz_ = 1;
+    spatial_sort_drift_ = 0.25f;
   }
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
   mutable_unknown_fields()->Clear();
@@ -278,6 +308,102 @@ bool Game::MergePartialFromCodedStream(
         } else {
           goto handle_uninterpreted;
         }
+        if (input->ExpectTag(56)) goto parse_physics_hz;
+        break;
+      }
+
+      // optional int32 physics_hz = 7 [default = 100];
+      case 7: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_physics_hz:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
+                 input, &physics_hz_)));
+          set_has_physics_hz();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(64)) goto parse_perception_hz;
+        break;
+      }
+
+      // optional int32 perception_hz = 8 [default = 10];
+      case 8: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_perception_hz:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
+                 input, &perception_hz_)));
+          set_has_perception_hz();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(72)) goto parse_ai_hz;
+        break;
+      }
+
+      // optional int32 ai_hz = 9 [default = 20];
+      case 9: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_ai_hz:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
+                 input, &ai_hz_)));
+          set_has_ai_hz();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(80)) goto parse_bullets_hz;
+        break;
+      }
+
+      // optional int32 bullets_hz = 10 [default = 100];
+      case 10: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_bullets_hz:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
+                 input, &bullets_hz_)));
+          set_has_bullets_hz();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(88)) goto parse_spatial_sort_hz;
+        break;
+      }
+
+      // optional int32 spatial_sort_hz = 11 [default = 1];
+      case 11: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_spatial_sort_hz:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
+                 input, &spatial_sort_hz_)));
+          set_has_spatial_sort_hz();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(101)) goto parse_spatial_sort_drift;
+        break;
+      }
+
+      // optional float spatial_sort_drift = 12 [default = 0.25];
+      case 12: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_FIXED32) {
+         parse_spatial_sort_drift:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   float, ::google::protobuf::internal::WireFormatLite::TYPE_FLOAT>(
+                 input, &spatial_sort_drift_)));
+          set_has_spatial_sort_drift();
+        } else {
+          goto handle_uninterpreted;
+        }
         if (input->ExpectAtEnd()) return true;
         break;
       }
@@ -330,6 +456,36 @@ void Game::SerializeWithCachedSizes(
     ::google::protobuf::internal::WireFormatLite::WriteFloat(6, this->max_wall_size(), output);
   }
 
+  // optional int32 physics_hz = 7 [default = 100];
+  if (has_physics_hz()) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt32(7, this->physics_hz(), output);
+  }
+
+  // optional int32 perception_hz = 8 [default = 10];
+  if (has_perception_hz()) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt32(8, this->perception_hz(), output);
+  }
+
+  // optional int32 ai_hz = 9 [default = 20];
+  if (has_ai_hz()) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt32(9, this->ai_hz(), output);
+  }
+
+  // optional int32 bullets_hz = 10 [default = 100];
+  if (has_bullets_hz()) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt32(10, this->bullets_hz(), output);
+  }
+
+  // optional int32 spatial_sort_hz = 11 [default = 1];
+  if (has_spatial_sort_hz()) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt32(11, this->spatial_sort_hz(), output);
+  }
+
+  // optional float spatial_sort_drift = 12 [default = 0.25];
+  if (has_spatial_sort_drift()) {
+    ::google::protobuf::internal::WireFormatLite::WriteFloat(12, this->spatial_sort_drift(), output);
+  }
+
   if (!unknown_fields().empty()) {
     ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
         unknown_fields(), output);
@@ -368,6 +524,36 @@ void Game::SerializeWithCachedSizes(
     target = ::google::protobuf::internal::WireFormatLite::WriteFloatToArray(6, this->max_wall_size(), target);
   }
 
+  // optional int32 physics_hz = 7 [default = 100];
+  if (has_physics_hz()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(7, this->physics_hz(), target);
+  }
+
+  // optional int32 perception_hz = 8 [default = 10];
+  if (has_perception_hz()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(8, this->perception_hz(), target);
+  }
+
+  // optional int32 ai_hz = 9 [default = 20];
+  if (has_ai_hz()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(9, this->ai_hz(), target);
+  }
+
+  // optional int32 bullets_hz = 10 [default = 100];
+  if (has_bullets_hz()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(10, this->bullets_hz(), target);
+  }
+
+  // optional int32 spatial_sort_hz = 11 [default = 1];
+  if (has_spatial_sort_hz()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(11, this->spatial_sort_hz(), target);
+  }
+
+  // optional float spatial_sort_drift = 12 [default = 0.25];
+  if (has_spatial_sort_drift()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteFloatToArray(12, this->spatial_sort_drift(), target);
+  }
+
   if (!unknown_fields().empty()) {
     target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
         unknown_fields(), target);
@@ -419,6 +605,48 @@ int Game::ByteSize() const {
       total_size += 1 + 4;
     }
 
+    // optional int32 physics_hz = 7 [default = 100];
+    if (has_physics_hz()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(
+          this->physics_hz());
+    }
+
+    // optional int32 perception_hz = 8 [default = 10];
+    if (has_perception_hz()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(
+          this->perception_hz());
+    }
+
+  }
+  if (_has_bits_[8 / 32] & (0xffu << (8 % 32))) {
+    // optional int32 ai_hz = 9 [default = 20];
+    if (has_ai_hz()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(
+          this->ai_hz());
+    }
+
+    // optional int32 bullets_hz = 10 [default = 100];
+    if (has_bullets_hz()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(
+          this->bullets_hz());
+    }
+
+    // optional int32 spatial_sort_hz = 11 [default = 1];
+    if (has_spatial_sort_hz()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(
+          this->spatial_sort_hz());
+    }
+
+    // optional float spatial_sort_drift = 12 [default = 0.25];
+    if (has_spatial_sort_drift()) {
+      total_size += 1 + 4;
+    }
+
   }
   if (!unknown_fields().empty()) {
     total_size +=
@@ -464,6 +692,26 @@ void Game::MergeFrom(const Game& from) {
     if (from.has_max_wall_size()) {
       set_max_wall_size(from.max_wall_size());
     }
+    if (from.has_physics_hz()) {
+      set_physics_hz(from.physics_hz());
+    }
+    if (from.has_perception_hz()) {
+      set_perception_hz(from.perception_hz());
+    }
+  }
+  if (from._has_bits_[8 / 32] & (0xffu << (8 % 32))) {
+    if (from.has_ai_hz()) {
+      set_ai_hz(from.ai_hz());
+    }
+    if (from.has_bullets_hz()) {
+      set_bullets_hz(from.bullets_hz());
+    }
+    if (from.has_spatial_sort_hz()) {
+      set_spatial_sort_hz(from.spatial_sort_hz());
+    }
+    if (from.has_spatial_sort_drift()) {
+      set_spatial_sort_drift(from.spatial_sort_drift());
+    }
   }
   mutable_unknown_fields()->MergeFrom(from.unknown_fields());
 }
@@ -493,6 +741,12 @@ void Game::Swap(Game* other) {
     std::swap(mobs_per_squad_, other->mobs_per_squad_);
     std::swap(num_walls_, other->num_walls_);
     std::swap(max_wall_size_, other->max_wall_size_);
+    std::swap(physics_hz_, other->physics_hz_);
+    std::swap(perception_hz_, other->perception_hz_);
+    std::swap(ai_hz_, other->ai_hz_);
+    std::swap(bullets_hz_, other->bullets_hz_);
+    std::swap(spatial_sort_hz_, other->spatial_sort_hz_);
+    std::swap(spatial_sort_drift_, other->spatial_sort_drift_);
     std::swap(_has_bits_[0], other->_has_bits_[0]);
     _unknown_fields_.Swap(&other->_unknown_fields_);
     std::swap(_cached_size_, other->_cached_size_);
@@ -134,6 +134,48 @@ class Game : public ::google::protobuf::Message {
   inline float max_wall_size() const;
   inline void set_max_wall_size(float value);
 
+  // optional int32 physics_hz = 7 [default = 100];
+  inline bool has_physics_hz() const;
+  inline void clear_physics_hz();
+  static const int kPhysicsHzFieldNumber = 7;
+  inline ::google::protobuf::int32 physics_hz() const;
+  inline void set_physics_hz(::google::protobuf::int32 value);
+
+  // optional int32 perception_hz = 8 [default = 10];
+  inline bool has_perception_hz() const;
+  inline void clear_perception_hz();
+  static const int kPerceptionHzFieldNumber = 8;
+  inline ::google::protobuf::int32 perception_hz() const;
+  inline void set_perception_hz(::google::protobuf::int32 value);
+
+  // optional int32 ai_hz = 9 [default = 20];
+  inline bool has_ai_hz() const;
+  inline void clear_ai_hz();
+  static const int kAiHzFieldNumber = 9;
+  inline ::google::protobuf::int32 ai_hz() const;
+  inline void set_ai_hz(::google::protobuf::int32 value);
+
+  // optional int32 bullets_hz = 10 [default = 100];
+  inline bool has_bullets_hz() const;
+  inline void clear_bullets_hz();
+  static const int kBulletsHzFieldNumber = 10;
+  inline ::google::protobuf::int32 bullets_hz() const;
+  inline void set_bullets_hz(::google::protobuf::int32 value);
+
+  // optional int32 spatial_sort_hz = 11 [default = 1];
+  inline bool has_spatial_sort_hz() const;
+  inline void clear_spatial_sort_hz();
+  static const int kSpatialSortHzFieldNumber = 11;
+  inline ::google::protobuf::int32 spatial_sort_hz() const;
+  inline void set_spatial_sort_hz(::google::protobuf::int32 value);
+
+  // optional float spatial_sort_drift = 12 [default = 0.25];
+  inline bool has_spatial_sort_drift() const;
+  inline void clear_spatial_sort_drift();
+  static const int kSpatialSortDriftFieldNumber = 12;
+  inline float spatial_sort_drift() const;
+  inline void set_spatial_sort_drift(float value);
+
   // @@protoc_insertion_point(class_scope:pang.config.Game)
  private:
   inline void set_has_width();
@@ -148,6 +190,18 @@ class Game : public ::google::protobuf::Message {
   inline void clear_has_num_walls();
   inline void set_has_max_wall_size();
   inline void clear_has_max_wall_size();
+  inline void set_has_physics_hz();
+  inline void clear_has_physics_hz();
+  inline void set_has_perception_hz();
+  inline void clear_has_perception_hz();
+  inline void set_has_ai_hz();
+  inline void clear_has_ai_hz();
+  inline void set_has_bullets_hz();
+  inline void clear_has_bullets_hz();
+  inline void set_has_spatial_sort_hz();
+  inline void clear_has_spatial_sort_hz();
+  inline void set_has_spatial_sort_drift();
+  inline void clear_has_spatial_sort_drift();
 
   ::google::protobuf::UnknownFieldSet _unknown_fields_;
 
@@ -157,9 +211,15 @@ class Game : public ::google::protobuf::Message {
   ::google::protobuf::int32 mobs_per_squad_;
   ::google::protobuf::int32 num_walls_;
   float max_wall_size_;
+  ::google::protobuf::int32 physics_hz_;
+  ::google::protobuf::int32 perception_hz_;
+  ::google::protobuf::int32 ai_hz_;
+  ::google::protobuf::int32 bullets_hz_;
+  ::google::protobuf::int32 spatial_sort_hz_;
+  float spatial_sort_drift_;
 
   mutable int _cached_size_;
-  ::google::protobuf::uint32 _has_bits_[(6 + 31) / 32];
+  ::google::protobuf::uint32 _has_bits_[(12 + 31) / 32];
 
   friend void  protobuf_AddDesc_game_2eproto();
   friend void protobuf_AssignDesc_game_2eproto();
@@ -307,6 +367,138 @@ inline void Game::set_max_wall_size(float value) {
   max_wall_size_ = value;
 }
 
+// optional int32 physics_hz = 7 [default = 100];
+inline bool Game::has_physics_hz() const {
+  return (_has_bits_[0] & 0x00000040u) != 0;
+}
+inline void Game::set_has_physics_hz() {
+  _has_bits_[0] |= 0x00000040u;
+}
+inline void Game::clear_has_physics_hz() {
+  _has_bits_[0] &= ~0x00000040u;
+}
+inline void Game::clear_physics_hz() {
+  physics_hz_ = 100;
+  clear_has_physics_hz();
+}
+inline ::google::protobuf::int32 Game::physics_hz() const {
+  return physics_hz_;
+}
+inline void Game::set_physics_hz(::google::protobuf::int32 value) {
+  set_has_physics_hz();
+  physics_hz_ = value;
+}
+
+// optional int32 perception_hz = 8 [default = 10];
+inline bool Game::has_perception_hz() const {
+  return (_has_bits_[0] & 0x00000080u) != 0;
+}
+inline void Game::set_has_perception_hz() {
+  _has_bits_[0] |= 0x00000080u;
+}
+inline void Game::clear_has_perception_hz() {
+  _has_bits_[0] &= ~0x00000080u;
+}
+inline void Game::clear_perception_hz() {
+  perception_hz_ = 10;
+  clear_has_perception_hz();
+}
+inline ::google::protobuf::int32 Game::perception_hz() const {
+  return perception_hz_;
+}
+inline void Game::set_perception_hz(::google::protobuf::int32 value) {
+  set_has_perception_hz();
+  perception_hz_ = value;
+}
+
+// optional int32 ai_hz = 9 [default = 20];
+inline bool Game::has_ai_hz() const {
+  return (_has_bits_[0] & 0x00000100u) != 0;
+}
+inline void Game::set_has_ai_hz() {
+  _has_bits_[0] |= 0x00000100u;
+}
+inline void Game::clear_has_ai_hz() {
+  _has_bits_[0] &= ~0x00000100u;
+}
+inline void Game::clear_ai_hz() {
+  ai_hz_ = 20;
+  clear_has_ai_hz();
+}
+inline ::google::protobuf::int32 Game::ai_hz() const {
+  return ai_hz_;
+}
+inline void Game::set_ai_hz(::google::protobuf::int32 value) {
+  set_has_ai_hz();
+  ai_hz_ = value;
+}
+
+// optional int32 bullets_hz = 10 [default = 100];
+inline bool Game::has_bullets_hz() const {
+  return (_has_bits_[0] & 0x00000200u) != 0;
+}
+inline void Game::set_has_bullets_hz() {
+  _has_bits_[0] |= 0x00000200u;
+}
+inline void Game::clear_has_bullets_hz() {
+  _has_bits_[0] &= ~0x00000200u;
+}
+inline void Game::clear_bullets_hz() {
+  bullets_hz_ = 100;
+  clear_has_bullets_hz();
+}
+inline ::google::protobuf::int32 Game::bullets_hz() const {
+  return bullets_hz_;
+}
+inline void Game::set_bullets_hz(::google::protobuf::int32 value) {
+  set_has_bullets_hz();
+  bullets_hz_ = value;
+}
+
+// optional int32 spatial_sort_hz = 11 [default = 1];
+inline bool Game::has_spatial_sort_hz() const {
+  return (_has_bits_[0] & 0x00000400u) != 0;
+}
+inline void Game::set_has_spatial_sort_hz() {
+  _has_bits_[0] |= 0x00000400u;
+}
+inline void Game::clear_has_spatial_sort_hz() {
+  _has_bits_[0] &= ~0x00000400u;
+}
+inline void Game::clear_spatial_sort_hz() {
+  spatial_sort_hz_ = 1;
+  clear_has_spatial_sort_hz();
+}
+inline ::google::protobuf::int32 Game::spatial_sort_hz() const {
+  return spatial_sort_hz_;
+}
+inline void Game::set_spatial_sort_hz(::google::protobuf::int32 value) {
+  set_has_spatial_sort_hz();
+  spatial_sort_hz_ = value;
+}
+
+// optional float spatial_sort_drift = 12 [default = 0.25];
+inline bool Game::has_spatial_sort_drift() const {
+  return (_has_bits_[0] & 0x00000800u) != 0;
+}
+inline void Game::set_has_spatial_sort_drift() {
+  _has_bits_[0] |= 0x00000800u;
+}
+inline void Game::clear_has_spatial_sort_drift() {
+  _has_bits_[0] &= ~0x00000800u;
+}
+inline void Game::clear_spatial_sort_drift() {
+  spatial_sort_drift_ = 0.25f;
+  clear_has_spatial_sort_drift();
+}
+inline float Game::spatial_sort_drift() const {
+  return spatial_sort_drift_;
+}
+inline void Game::set_spatial_sort_drift(float value) {
+  set_has_spatial_sort_drift();
+  spatial_sort_drift_ = value;
+}
+
 
 // @@protoc_insertion_point(namespace_scope)
 
@@ -0,0 +1,191 @@
+#include "sampler.hpp"
+
+using namespace pang;
+
+namespace pang
+{
+  Sampler g_sampler;
+}
+
+namespace
+{
+  // set on the thread being sampled
+  thread_local bool t_sampledThread = false;
+
+#ifndef _WIN32
+  // the signal handler and the signal trampoline are at the top of each stack
+  const int SKIP_FRAMES = 2;
+
+  //----------------------------------------------------------------------------------
+  const string& Symbolize(void* addr, bool returnAddr, unordered_map<void*, string>* cache)
+  {
+    auto it = cache->find(addr);
+    if (it != cache->end())
+      return it->second;
+
+    // return addresses point after the call, so look up the call instruction instead
+    void* lookup = returnAddr ? (char*)addr - 1 : addr;
+    string name;
+    Dl_info info = {};
+    bool found = dladdr(lookup, &info) != 0;
+    if (found && info.dli_sname)
+    {
+      int status = 0;
+      char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+      name = status == 0 && demangled ? demangled : info.dli_sname;
+      free(demangled);
+    }
+    else if (found && info.dli_fname)
+    {
+      // no symbol (static functions, or an executable linked without -rdynamic), so
+      // use the module and offset
+      const char* sep = strrchr(info.dli_fname, '/');
+      char buf[256];
+      snprintf(buf, sizeof(buf), "%s+0x%llx", sep ? sep + 1 : info.dli_fname,
+          (unsigned long long)((char*)lookup - (char*)info.dli_fbase));
+      name = buf;
+    }
+    else
+    {
+      // not in any loaded module, so all there is is the address
+      char buf[32];
+      snprintf(buf, sizeof(buf), "0x%llx", (unsigned long long)lookup);
+      name = buf;
+    }
+
+    // ';' separates frames in the folded format
+    std::replace(name.begin(), name.end(), ';', ':');
+    return (*cache)[addr] = name;
+  }
+#endif
+}
+
+//----------------------------------------------------------------------------------
+Sampler::Sampler()
+    : _numSamples(0)
+    , _numDropped(0)
+    , _running(false)
+{
+}
+
+//----------------------------------------------------------------------------------
+Sampler::~Sampler()
+{
+  Stop();
+}
+
+//----------------------------------------------------------------------------------
+bool Sampler::Start(u32 hz)
+{
+#ifdef _WIN32
+  printf("the sampling profiler isn't supported on windows\n");
+  return false;
+#else
+  if (_running || hz == 0)
+    return false;
+
+  _samples.resize(MAX_SAMPLES);
+  _numSamples = 0;
+  _numDropped = 0;
+  t_sampledThread = true;
+
+  // the first backtrace call can load libgcc and allocate, so get that out of the way
+  // before it's called from the signal handler
+  void* frames[MAX_DEPTH];
+  backtrace(frames, MAX_DEPTH);
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = &Sampler::OnSignal;
+  sa.sa_flags = SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+  if (sigaction(SIGPROF, &sa, nullptr) != 0)
+    return false;
+
+  struct itimerval timer;
+  timer.it_interval.tv_sec = 0;
+  timer.it_interval.tv_usec = max<u32>(1, 1000000 / hz);
+  timer.it_value = timer.it_interval;
+  if (setitimer(ITIMER_PROF, &timer, nullptr) != 0)
+    return false;
+
+  _running = true;
+  return true;
+#endif
+}
+
+//----------------------------------------------------------------------------------
+void Sampler::Stop()
+{
+#ifndef _WIN32
+  if (!_running)
+    return;
+
+  struct itimerval timer;
+  memset(&timer, 0, sizeof(timer));
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  signal(SIGPROF, SIG_IGN);
+  _running = false;
+#endif
+}
+
+//----------------------------------------------------------------------------------
+void Sampler::OnSignal(int sig)
+{
+#ifndef _WIN32
+  Sampler& s = g_sampler;
+  if (!t_sampledThread || !s._running)
+  {
+    s._numDropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  u32 idx = s._numSamples.fetch_add(1, std::memory_order_relaxed);
+  if (idx >= MAX_SAMPLES)
+  {
+    s._numDropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  Sample& sample = s._samples[idx];
+  sample.phase = t_curPhase;
+  sample.depth = backtrace(sample.frames, MAX_DEPTH);
+#endif
+}
+
+//----------------------------------------------------------------------------------
+bool Sampler::Write(const string& filename) const
+{
+#ifdef _WIN32
+  return false;
+#else
+  u32 numSamples = min<u32>(_numSamples, MAX_SAMPLES);
+
+  // fold identical stacks, outermost frame first
+  unordered_map<void*, string> symbols;
+  map<string, u32> stacks;
+  for (u32 i = 0; i < numSamples; ++i)
+  {
+    const Sample& sample = _samples[i];
+    string stack = sample.phase == Phase::PhaseCount ? "Other" : PhaseName(sample.phase);
+    for (int j = sample.depth - 1; j >= SKIP_FRAMES; --j)
+    {
+      stack += ';';
+      stack += Symbolize(sample.frames[j], j > SKIP_FRAMES, &symbols);
+    }
+    stacks[stack]++;
+  }
+
+  FILE* f = fopen(filename.c_str(), "w");
+  if (!f)
+    return false;
+
+  for (const auto& kv : stacks)
+    fprintf(f, "%s %u\n", kv.first.c_str(), kv.second);
+  fclose(f);
+
+  printf("wrote %u samples (%u stacks, %u dropped) to %s\n",
+      numSamples, (u32)stacks.size(), (u32)_numDropped, filename.c_str());
+  return true;
+#endif
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "types.hpp"
+#include "profiler.hpp"
+
+namespace pang
+{
+  // Opt-in sampling profiler. A SIGPROF interval timer interrupts the process, and the
+  // samples that land on the thread that called Start record the call stack and the
+  // current frame phase. At exit the stacks are symbolized and written as folded stacks
+  // for flamegraph.pl, with the phase as the root frame. Not available on windows
+  struct Sampler
+  {
+    enum { MAX_SAMPLES = 1 << 16, MAX_DEPTH = 32 };
+
+    Sampler();
+    ~Sampler();
+
+    bool Start(u32 hz);
+    void Stop();
+    bool Write(const string& filename) const;
+
+  private:
+    static void OnSignal(int sig);
+
+    struct Sample
+    {
+      Phase phase;
+      int depth;
+      void* frames[MAX_DEPTH];
+    };
+
+    // preallocated when started, so the signal handler never allocates
+    vector<Sample> _samples;
+    atomic<u32> _numSamples;
+    // samples that hit another thread, or a full buffer
+    atomic<u32> _numDropped;
+    bool _running;
+  };
+
+  extern Sampler g_sampler;
+}
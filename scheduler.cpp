@@ -0,0 +1,46 @@
+#include "scheduler.hpp"
+
+using namespace pang;
+
+//----------------------------------------------------------------------------------
+SystemScheduler::SystemScheduler()
+    : _due(0)
+{
+  memset(_period, 0, sizeof(_period));
+  memset(_acc, 0, sizeof(_acc));
+  memset(_sinceRun, 0, sizeof(_sinceRun));
+  memset(_elapsed, 0, sizeof(_elapsed));
+}
+
+//----------------------------------------------------------------------------------
+void SystemScheduler::SetRate(SimSystem system, u32 hz)
+{
+  int idx = (int)system;
+  _period[idx] = hz ? 1000000 / hz : 0;
+  // starting with a whole period makes the system due on the next tick
+  _acc[idx] = _period[idx];
+  _sinceRun[idx] = 0;
+  _elapsed[idx] = 0;
+}
+
+//----------------------------------------------------------------------------------
+void SystemScheduler::Tick(u64 tick_us)
+{
+  _due = 0;
+  for (int i = 0; i < NUM_SYSTEMS; ++i)
+  {
+    if (!_period[i])
+      continue;
+
+    _sinceRun[i] += tick_us;
+    if (_acc[i] >= _period[i])
+    {
+      _due |= 1 << i;
+      _elapsed[i] = _sinceRun[i];
+      _sinceRun[i] = 0;
+      // a system can't run more than once a tick, so don't let it build up a backlog
+      _acc[i] = min(_acc[i] - _period[i], _period[i]);
+    }
+    _acc[i] += tick_us;
+  }
+}
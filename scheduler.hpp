@@ -0,0 +1,46 @@
+#pragma once
+#include "types.hpp"
+
+namespace pang
+{
+  // The systems dispatched from the physics ticks
+  enum class SimSystem
+  {
+    Perception,
+    Ai,
+    Bullets,
+    SpatialSort,
+    NumSystems,
+  };
+
+  // Runs each system at its own rate on the fixed physics time step, so their cost
+  // doesn't depend on how often the frame loop calls Simulation::Update. Every tick adds
+  // the tick duration to each system, and a system is due once it has a whole period.
+  // A system faster than the physics runs once per tick. A period doesn't have to be a
+  // whole number of ticks, so a time dependent system steps by Elapsed, not Period
+  class SystemScheduler
+  {
+  public:
+    enum { NUM_SYSTEMS = (int)SimSystem::NumSystems };
+
+    SystemScheduler();
+
+    // 0 hz turns the system off. a system is due on the first tick after its rate is set
+    void SetRate(SimSystem system, u32 hz);
+    // in us, or 0 if the system is off
+    u64 Period(SimSystem system) const { return _period[(int)system]; }
+
+    // advances every system by tick_us, and updates which are due this tick
+    void Tick(u64 tick_us);
+    bool Due(SimSystem system) const { return (_due & (1 << (int)system)) != 0; }
+    // in us, the ticks accumulated since a system due this tick last ran
+    u64 Elapsed(SimSystem system) const { return _elapsed[(int)system]; }
+
+  private:
+    u64 _period[NUM_SYSTEMS];
+    u64 _acc[NUM_SYSTEMS];
+    u64 _sinceRun[NUM_SYSTEMS];
+    u64 _elapsed[NUM_SYSTEMS];
+    u32 _due;
+  };
+}
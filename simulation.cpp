@@ -0,0 +1,655 @@
+#include "simulation.hpp"
+#include "behavior.hpp"
+#include "profiler.hpp"
+#include "metrics.hpp"
+#include "level_stats.hpp"
+#include "flight_recorder.hpp"
+#include "checksum.hpp"
+#include "async_log.hpp"
+
+using namespace pang;
+using namespace bristol;
+
+namespace
+{
+  // the block of tiles an entity has to leave to count as drifted, as a shift of the tile
+  // coordinates
+  const u32 DRIFT_BLOCK_SHIFT = 3;
+
+  //----------------------------------------------------------------------------------
+  u32 HilbertIndex(u32 side, u32 x, u32 y)
+  {
+    // the distance along the curve filling a side x side square (side a power of 2), one
+    // quadrant level at a time
+    u32 d = 0;
+    for (u32 s = side / 2; s > 0; s /= 2)
+    {
+      u32 rx = (x & s) ? 1 : 0;
+      u32 ry = (y & s) ? 1 : 0;
+      d += s * s * ((3 * rx) ^ ry);
+      // rotate the quadrant, so the curve inside it is in the canonical orientation
+      if (ry == 0)
+      {
+        if (rx == 1)
+        {
+          x = side - 1 - x;
+          y = side - 1 - y;
+        }
+        std::swap(x, y);
+      }
+    }
+    return d;
+  }
+}
+
+//----------------------------------------------------------------------------------
+Simulation::Simulation()
+    : _lifecycle(&_entities)
+    , _gridSize(25)
+    , _playerDead(false)
+    , _pausedEnemies(false)
+    , _localPlayerId(NO_ENTITY)
+    , _tickUs(0)
+    , _tickAcc(0)
+    , _numTicks(0)
+    , _ownsCoordinator(false)
+    , _hilbertSide(1)
+    , _numDrifted(0)
+{
+}
+
+//----------------------------------------------------------------------------------
+Simulation::~Simulation()
+{
+  if (_ownsCoordinator)
+    Coordinator::Destroy();
+}
+
+//----------------------------------------------------------------------------------
+bool Simulation::Init(const string& configFile)
+{
+  config::Game gameConfig;
+  if (!bristol::LoadProto(configFile.c_str(), &gameConfig))
+    return false;
+
+  // the level config lives next to the game config
+  size_t sep = configFile.find_last_of("/\\");
+  string configDir = sep == string::npos ? "" : configFile.substr(0, sep + 1);
+
+  pang::level::Level levelConfig;
+  if (!bristol::LoadProto((configDir + "level1.pb").c_str(), &levelConfig))
+    return false;
+
+  return Init(gameConfig, levelConfig);
+}
+
+//----------------------------------------------------------------------------------
+bool Simulation::Init(const config::Game& gameConfig, const pang::level::Level& levelConfig)
+{
+  _gameConfig = gameConfig;
+  if (_gameConfig.physics_hz() <= 0)
+  {
+    printf("physics_hz must be positive, got %d\n", _gameConfig.physics_hz());
+    return false;
+  }
+
+  _tickUs = 1000000 / _gameConfig.physics_hz();
+  _scheduler.SetRate(SimSystem::Perception, max(0, _gameConfig.perception_hz()));
+  _scheduler.SetRate(SimSystem::Ai, max(0, _gameConfig.ai_hz()));
+  _scheduler.SetRate(SimSystem::Bullets, max(0, _gameConfig.bullets_hz()));
+  _scheduler.SetRate(SimSystem::SpatialSort, max(0, _gameConfig.spatial_sort_hz()));
+
+  if (!_level.Init(_gameConfig.width(), _gameConfig.height(), levelConfig))
+    return false;
+
+  u32 w, h;
+  _level.GetSize(&w, &h);
+  while (_hilbertSide < max(w, h))
+    _hilbertSide *= 2;
+
+  if (!Coordinator::Create())
+    return false;
+  _ownsCoordinator = true;
+
+  _lifecycle.AddCleanupHook([this](EntityId id, u32 slot) { OnDestroyEntity(id, slot); });
+  _lifecycle.AddCleanupHook([](EntityId id, u32) { RemoveWanderState(id); });
+
+  // create local player
+  Vector2f p(0,0);
+  p = GetEmptyPos();
+  u32 slot;
+  _localPlayerId = _entities.Add(p, &slot);
+
+  _level.SetEntity(WorldToTile(p), _localPlayerId);
+
+  SpawnEnemies();
+
+  return true;
+}
+
+//----------------------------------------------------------------------------------
+u64 Simulation::TickDuration() const
+{
+  return _tickUs;
+}
+
+//----------------------------------------------------------------------------------
+Vector2f Simulation::GetEmptyPos()
+{
+  LEVEL_CALLER(Spawn);
+  u32 w, h;
+  _level.GetSize(&w, &h);
+  while (true)
+  {
+    u32 x = rand() % w;
+    u32 y = rand() % h;
+    Level::Cell* cell = 0;
+    if (_level.GetCell(Tile(x, y), &cell) && cell->terrain == 0)
+    {
+      return (float)_gridSize * Vector2f(x, y);
+    }
+  }
+  return Vector2f(0,0);
+}
+
+//----------------------------------------------------------------------------------
+Vector2f Simulation::GetEmptyPos(const Vector2f& center, float radius)
+{
+  // find an empty position with LOS to the center
+  LEVEL_CALLER(Spawn);
+  u32 w, h;
+  _level.GetSize(&w, &h);
+  Tile tile = WorldToTile(center);
+  u32 x0 = tile.x;
+  u32 y0 = tile.y;
+  while (true)
+  {
+    u32 x = (u32)((s32)x0 + randf(-radius, radius));
+    u32 y = (u32)((s32)y0 + randf(-radius, radius));
+    if (_level.IsValidPos(Tile(x, y)) /*&& _level.IsVisible(x0, y0, x, y)*/)
+    {
+      // Check LOS to the center
+      return (float)_gridSize * Vector2f(x, y);
+    }
+  }
+  return Vector2f(0,0);
+}
+
+//----------------------------------------------------------------------------------
+void Simulation::SpawnEnemies()
+{
+  // spawning again adds new squads
+  for (int i = 0; i < _gameConfig.num_squads(); ++i)
+  {
+    if (!SpawnSquad())
+      return;
+  }
+}
+
+//----------------------------------------------------------------------------------
+bool Simulation::SpawnSquad()
+{
+  SquadId squadId;
+  if (!_freeSquads.empty())
+  {
+    squadId = _freeSquads.back();
+    _freeSquads.pop_back();
+  }
+  else if (_squadSizes.size() < NO_SQUAD)
+  {
+    squadId = (SquadId)_squadSizes.size();
+    _squadSizes.push_back(0);
+    PROFILE_COST_SQUADS(_squadSizes.size());
+  }
+  else
+  {
+    g_asyncLog.Write(LogLevel::Warning, "out of squad ids");
+    return false;
+  }
+
+  bool res = true;
+  Vector2f squadCenter(GetEmptyPos());
+  for (int j = 0; j < _gameConfig.mobs_per_squad(); ++j)
+  {
+    u32 e;
+    EntityId id = _entities.Add(GetEmptyPos(squadCenter, 4), &e);
+    if (id == NO_ENTITY)
+    {
+      g_asyncLog.Write(LogLevel::Warning, "the entity store is full");
+      res = false;
+      break;
+    }
+
+    _entities._squadId[e] = squadId;
+    ++_squadSizes[squadId];
+    ++_numDrifted;
+    _level.SetEntity(WorldToTile(_entities._pos[e]), id);
+  }
+
+  if (_squadSizes[squadId] == 0)
+    _freeSquads.push_back(squadId);
+
+  return res;
+}
+
+//----------------------------------------------------------------------------------
+void Simulation::OnDestroyEntity(EntityId id, u32 slot)
+{
+  _level.ClearEntity(WorldToTile(_entities._pos[slot]), id);
+
+  if (id == _localPlayerId)
+    _playerDead = true;
+
+  SquadId squadId = _entities._squadId[slot];
+  if (squadId != NO_SQUAD && --_squadSizes[squadId] == 0)
+    _freeSquads.push_back(squadId);
+}
+
+//----------------------------------------------------------------------------------
+void Simulation::SortEntities()
+{
+  // the keys hold the hilbert index over the slot, so the sort is stable
+  u32 n = _entities.Size();
+  _sortKeys.resize(n);
+  for (u32 e = 0; e < n; ++e)
+  {
+    Tile tile = WorldToTile(_entities._pos[e]);
+    u32 x = min(tile.x, _hilbertSide - 1);
+    u32 y = min(tile.y, _hilbertSide - 1);
+    _sortKeys[e] = ((u64)HilbertIndex(_hilbertSide, x, y) << 32) | e;
+  }
+
+  sort(_sortKeys.begin(), _sortKeys.end());
+
+  _sortOrder.resize(n);
+  for (u32 i = 0; i < n; ++i)
+    _sortOrder[i] = (u32)_sortKeys[i];
+
+  _entities.Reorder(_sortOrder);
+  _numDrifted = 0;
+}
+
+//----------------------------------------------------------------------------------
+void Simulation::UpdateEnemies()
+{
+  if (_playerDead || _pausedEnemies)
+    return;
+
+  LEVEL_CALLER(AvoidWall);
+  const float MAX_FORCE = 0.0005f;
+
+  // entities destroyed this tick stay in the store until the lifecycle flush, but are
+  // neither steered nor pursued
+  u32 localPlayer;
+  if (!FindLocalPlayer(&localPlayer) || _lifecycle.IsDestroyed(localPlayer))
+    return;
+
+  Vector2f playerPos(_entities._pos[localPlayer]);
+
+  for (u32 e = 0, n = _entities.Size(); e < n; ++e)
+  {
+    if (e == localPlayer || _lifecycle.IsDestroyed(e))
+      continue;
+
+    Vector2f& force = _entities._force[e];
+//    force = BehaviorPursuit(_entities, e, localPlayer);
+//    force = 0.40f * BehaviorWander(_entities, e);
+    force = 0.40f * BehaviorArrive(_entities, e, playerPos);
+    Level::Cell* cell;
+    if (_level.GetCell(WorldToTile(_entities._pos[e]), &cell))
+    {
+      force += 0.60f * BehaviorAvoidWall(_entities, e, *cell);
+    }
+
+    float len = min(MAX_FORCE, Length(force));
+    Normalize(force);
+    force *= len;
+
+  }
+
+#if 0
+  for (auto& kv : _entities)
+  {
+    Entity* e = kv.second.get();
+    if (e->_id == _localPlayerId)
+      continue;
+
+    // turn towards player
+    Vector2f dir = (playerPos - e->_pos);
+    Normalize(dir);
+
+    float a = atan2f(dir.x, dir.y);
+    e->_rot = a;
+
+    Vector2f dest(e->_pos + (float)_gridSize * dir);
+    Level::Cell* cell;
+    if (_level.GetCell(WorldToTile(dest), &cell))
+    {
+      // don't move to an occupied cell, or one which is another entity's dest
+      if ((cell->entityId && cell->entityId != e->_id) || (cell->destEntityId && cell->destEntityId != e->_id))
+        continue;
+    }
+
+    AddMoveAction(e->_id, e->_pos, dest);
+
+    if (_debugDraw & 2)
+      AddMessage(MessageType::Debug, toString("dx: %.2f, dy: %.2f, a: %.2f", dir.x, dir.y, a));
+
+    //SpawnBullet(e);
+  }
+#endif
+}
+
+//----------------------------------------------------------------------------------
+Vector2f Simulation::SnappedPos(const Vector2f& pos) const
+{
+  float ff = (float)_gridSize;
+  float f = ff - 1;
+  int x = (int)((pos.x + f) / ff);
+  int y = (int)((pos.y + f) / ff);
+  return Vector2f(x * ff, y * ff);
+}
+
+//----------------------------------------------------------------------------------
+Vector2f Simulation::ClampedDestination(const Vector2f& pos, const Vector2f& dir) const
+{
+  return SnappedPos(pos + (float)_gridSize * dir);
+}
+
+//----------------------------------------------------------------------------------
+bool Simulation::SpawnBullet(EntityId id)
+{
+  #if 0
+  u32 e;
+  if (!_entities.Find(id, &e))
+    return false;
+
+  // one shot a second
+  EntityCold& cold = _entities._cold[e];
+  if (cold._lastActionTick != EntityCold::NO_ACTION && _numTicks - cold._lastActionTick < (u32)_gameConfig.physics_hz())
+  {
+    return false;
+  }
+
+  cold._lastActionTick = _numTicks;
+
+  Vector2f c(_gridSize/2, _gridSize/2);
+
+  Vector2f dir = _entities.Dir(e);
+  Vector2f pos = SnappedPos(_entities._pos[e]) + c + (float)_gridSize * dir;
+  if (_level.IsValidPos(WorldToTile(pos)))
+  {
+    ActionBullet* b = new ActionBullet(id);
+    b->pos = pos;
+    b->dir = dir;
+    _actionQueue.push_back(b);
+  }
+#endif
+  return true;
+}
+
+//----------------------------------------------------------------------------------
+void Simulation::Update(u64 delta_us)
+{
+  // calc the number of physics ticks to take (the physics run with a fixed time step).
+  // the other systems are dispatched from the ticks they're due on, so a frame without a
+  // tick runs nothing
+  _tickAcc += delta_us;
+  PROFILE_COST_UPDATE();
+  u32 numSubsteps = 0;
+  while (_tickAcc > _tickUs)
+  {
+    {
+      PROFILE_PHASE(Physics);
+      TRACE_SCOPE("PhysicsUpdate");
+      PROFILE_TICK();
+      if (g_flightRecorder.IsRecording())
+        g_flightRecorder.Record(_numTicks, _entities, _visibility);
+      PhysicsUpdate(_tickUs / 1000.0f);
+    }
+    _tickAcc -= _tickUs;
+    ++_numTicks;
+    ++numSubsteps;
+
+    _scheduler.Tick(_tickUs);
+    if (_scheduler.Due(SimSystem::Perception))
+    {
+      PROFILE_PHASE(Visibility);
+      UpdateVisibility();
+    }
+
+    if (_scheduler.Due(SimSystem::Bullets))
+    {
+      PROFILE_PHASE(Bullets);
+      UpdateBullets(_scheduler.Elapsed(SimSystem::Bullets) / 1e6f);
+    }
+
+    if (_scheduler.Due(SimSystem::Ai))
+    {
+      {
+        PROFILE_PHASE(Coordinator);
+        COORDINATOR.Update();
+      }
+
+      {
+        PROFILE_PHASE(Enemies);
+        UpdateEnemies();
+      }
+    }
+
+    // the entities destroyed during the tick are removed before it's checksummed
+    _lifecycle.Flush();
+
+    float maxDrift = _gameConfig.spatial_sort_drift();
+    if (_scheduler.Due(SimSystem::SpatialSort) || (maxDrift > 0 && _numDrifted > maxDrift * _entities.Size()))
+    {
+      PROFILE_PHASE(SpatialSort);
+      SortEntities();
+    }
+
+    if (g_checksums.IsOpen())
+      g_checksums.Write(_numTicks, _entities, _bullets, _level);
+  }
+
+  u32 localPlayer;
+  if (FindLocalPlayer(&localPlayer))
+    _level.SetHeat(WorldToTile(_entities._pos[localPlayer]), 255);
+
+  PROFILE_COUNT(Entities, _entities.Size());
+  PROFILE_COUNT(Bullets, _bullets.size());
+
+  g_metrics.Add(Metric::Updates, 1);
+  g_metrics.Add(Metric::PhysicsTicks, numSubsteps);
+  g_metrics.Set(Metric::PhysicsSubsteps, numSubsteps);
+  g_metrics.Set(Metric::Entities, _entities.Size());
+  g_metrics.Set(Metric::DeadEntitiesTotal, _lifecycle.NumDestroyed());
+  g_metrics.Set(Metric::Bullets, _bullets.size());
+}
+
+//----------------------------------------------------------------------------------
+void Simulation::PhysicsUpdate(float delta_ms)
+{
+  // verlet integration:
+  // xi+1 = xi + (xi - xi-1) + a * dt * dt
+
+  LEVEL_CALLER(Physics);
+  float deltaSq = delta_ms * delta_ms;
+  float invDelta = 1.0f / delta_ms;
+
+  u32 localPlayer = EntityStore::INVALID_SLOT;
+  FindLocalPlayer(&localPlayer);
+
+  for (u32 e = 0, n = _entities.Size(); e < n; ++e)
+  {
+    Vector2f& pos = _entities._pos[e];
+    Vector2f& vel = _entities._vel[e];
+    Vector2f& force = _entities._force[e];
+    Vector2f prevPos = pos;
+    // F = m/a => a = F/m
+    Vector2f damping = -0.001f * vel;
+    Vector2f acc = (force + damping) * _entities._invMass[e];
+    force = Vector2f(0,0);
+    Vector2f newPos = pos + (pos - _entities._prevPos[e]) + acc * deltaSq;
+
+    Level::Cell* cell;
+    if (!_level.GetCell(WorldToTile(newPos), &cell) || cell->terrain > 0)
+    {
+      // penetration, so project the entity backwards
+      Vector2f dir = (newPos - prevPos);
+      pos -= dir;
+      _entities._collision[e] = 1;
+    }
+    else
+    {
+      pos = newPos;
+      _entities._collision[e] = 0;
+    }
+
+    // move the entity's stamp in the level along with it
+    Tile prevTile = WorldToTile(prevPos);
+    Tile tile = WorldToTile(pos);
+    if (!(tile == prevTile))
+    {
+      EntityId id = _entities._id[e];
+      _level.ClearEntity(prevTile, id);
+      _level.SetEntity(tile, id);
+      if (((tile.x ^ prevTile.x) | (tile.y ^ prevTile.y)) >> DRIFT_BLOCK_SHIFT)
+        ++_numDrifted;
+    }
+    vel = (pos - _entities._prevPos[e]) * invDelta;
+    _entities._prevPos[e] = prevPos;
+
+    if (e != localPlayer)
+      _entities._rot[e] = atan2f(vel.x, -vel.y);
+  }
+}
+
+//----------------------------------------------------------------------------------
+void Simulation::UpdateVisibility()
+{
+  LEVEL_CALLER(Visibility);
+  u32 numChecks = 0;
+
+  u32 localPlayer = EntityStore::INVALID_SLOT;
+  FindLocalPlayer(&localPlayer);
+
+  // each monster sees at most the player, and the player at most every monster
+  _visibility.Begin(_entities.NumHandles(), 2 * _entities.Size());
+
+  const Vector2f* positions = _entities._pos.data();
+  for (u32 e = 0, n = _entities.Size(); e < n; ++e)
+  {
+    // entities destroyed this tick stay in the store until the lifecycle flush, but
+    // neither see nor are seen
+    if (_lifecycle.IsDestroyed(e))
+      continue;
+
+    PROFILE_COST(Visibility, _entities._squadId[e]);
+    _visibility.AddViewer(_entities._id[e]);
+    bool isLocalPlayer = e == localPlayer;
+
+    float viewDistance = _entities._viewDistance[e];
+    float distSq = viewDistance * viewDistance;
+    float fov = _entities._fov[e];
+    const Vector2f& pos = positions[e];
+    const Vector2f& dir = _entities.Dir(e);
+
+    const Tile& t0 = WorldToTile(pos);
+
+    // the player looks for monsters, and the monsters only for the player
+    u32 begin = isLocalPlayer ? 0 : localPlayer;
+    u32 end = isLocalPlayer ? n : localPlayer + 1;
+    if (localPlayer == EntityStore::INVALID_SLOT)
+      end = begin;
+
+    for (u32 e2 = begin; e2 < end; ++e2)
+    {
+      if (e2 == e || _lifecycle.IsDestroyed(e2))
+        continue;
+
+      // first, check distance
+      float tmp = DistSq(pos, positions[e2]);
+      if (tmp > distSq)
+        continue;
+
+      // check angle between direction vector and vector to entity
+      Vector2f toEntity(Normalize(positions[e2] - pos));
+
+      // dot(a,b) = cos(theta)
+      float angle = acosf(Dot(toEntity, dir));
+      if (angle < fov)
+      {
+        // do a LOS check
+        const Tile& t1 = WorldToTile(positions[e2]);
+
+        ++numChecks;
+        if (_level.IsVisible(t0.x, t0.y, t1.x, t1.y))
+          _visibility.AddTarget(_entities._id[e2]);
+      }
+    }
+  }
+
+  PROFILE_COUNT(VisibilityChecks, numChecks);
+  g_metrics.Add(Metric::LosChecks, numChecks);
+
+  if (localPlayer == EntityStore::INVALID_SLOT)
+    return;
+
+  // report the monsters that have spotted the player to the coordinator
+  Vector2f playerPos = positions[localPlayer];
+  _visibility.ForEach([&](EntityId viewer, EntityId target)
+  {
+    if (target == _localPlayerId)
+      COORDINATOR.SendMessage(AiMessage::MakePlayerSpotted(playerPos));
+  });
+}
+
+//----------------------------------------------------------------------------------
+void Simulation::UpdateBullets(float delta_s)
+{
+  LEVEL_CALLER(Bullets);
+  for (auto it = _bullets.begin(); it != _bullets.end();)
+  {
+    Bullet& b = *it;
+    b.pos = b.pos + 100 * delta_s * b.dir;
+    if (!_level.IsValidPos(WorldToTile(b.pos)))
+    {
+      it = _bullets.erase(it);
+    }
+    else
+    {
+      bool collision = false;
+      // check for player collision
+      Vector2f bulletPos = SnappedPos(b.pos);
+      for (u32 e = 0, n = _entities.Size(); e < n; ++e)
+      {
+        EntityId id = _entities._id[e];
+        if (id != b.entityId && !_lifecycle.IsDestroyed(e) && SnappedPos(_entities._pos[e]) == bulletPos)
+        {
+          collision = true;
+          _lifecycle.Destroy(id);
+          break;
+        }
+      }
+
+      it = collision ? _bullets.erase(it) : ++it;
+    }
+  }
+
+}
+
+//----------------------------------------------------------------------------------
+Tile Simulation::WorldToTile(const Vector2f& p) const
+{
+  float g = _gridSize;
+  float ofs = g / 2;
+  return Tile((u32)((p.x + ofs) / g), (u32)((p.y + ofs)/ g));
+}
+
+//----------------------------------------------------------------------------------
+Vector2f Simulation::TileToWorld(u32 x, u32 y) const
+{
+  // returns a point in the center of the tile
+  float g = (float)_gridSize;
+  return Vector2f(x * g + g / 2, y * g + g / 2);
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "types.hpp"
+#include "entity.hpp"
+#include "lifecycle.hpp"
+#include "level.hpp"
+#include "scheduler.hpp"
+#include "visibility.hpp"
+#include "protocol/game.pb.h"
+
+namespace pang
+{
+  struct Bullet
+  {
+    EntityId entityId;
+    Vector2f dir;
+    Vector2f pos;
+  };
+
+  // The game simulation: level, entities, physics and ai. Contains no windowing or
+  // rendering, so it can be linked into headless tools.
+  class Simulation
+  {
+  public:
+    Simulation();
+    ~Simulation();
+    bool Init(const string& configFile);
+    bool Init(const config::Game& gameConfig, const pang::level::Level& levelConfig);
+
+    // advances the simulation by delta_us. the physics run with a fixed time step, so
+    // this takes any number of physics ticks, and each tick runs the systems that are due
+    // at their configured rates
+    void Update(u64 delta_us);
+
+    // spawns num_squads squads
+    void SpawnEnemies();
+    // spawns a squad of mobs_per_squad around a random position. false if there are no
+    // free squad or entity ids
+    bool SpawnSquad();
+    bool SpawnBullet(EntityId id);
+
+    Tile WorldToTile(const Vector2f& p) const;
+    Vector2f TileToWorld(u32 x, u32 y) const;
+    Vector2f SnappedPos(const Vector2f& pos) const;
+
+    EntityStore& Entities() { return _entities; }
+    const EntityStore& Entities() const { return _entities; }
+    // entities are destroyed through the lifecycle, which removes them at the end of the tick
+    EntityLifecycle& Lifecycle() { return _lifecycle; }
+    const vector<Bullet>& Bullets() const { return _bullets; }
+    // what each entity saw in the last perception update
+    const VisibilityResults& Visibility() const { return _visibility; }
+    // false once the local player is dead
+    bool FindLocalPlayer(u32* slot) const { return _entities.Find(_localPlayerId, slot); }
+    EntityId LocalPlayerId() const { return _localPlayerId; }
+    bool PlayerDead() const { return _playerDead; }
+    u32 GridSize() const { return _gridSize; }
+    u32 NumTicks() const { return _numTicks; }
+    u64 TickDuration() const;
+    Level& GetLevel() { return _level; }
+    const Level& GetLevel() const { return _level; }
+    const config::Game& GameConfig() const { return _gameConfig; }
+
+  private:
+    Vector2f GetEmptyPos();
+    Vector2f GetEmptyPos(const Vector2f& center, float radius);
+    Vector2f ClampedDestination(const Vector2f& pos, const Vector2f& dir) const;
+
+    void PhysicsUpdate(float delta_ms);
+    void UpdateVisibility();
+    void UpdateBullets(float delta_s);
+    void UpdateEnemies();
+    void OnDestroyEntity(EntityId id, u32 slot);
+    // orders the entity storage along a hilbert curve over the tiles
+    void SortEntities();
+
+    pang::config::Game _gameConfig;
+
+    EntityStore _entities;
+    EntityLifecycle _lifecycle;
+
+    Level _level;
+    vector<Bullet> _bullets;
+    VisibilityResults _visibility;
+
+    u32 _gridSize;
+    bool _playerDead;
+    bool _pausedEnemies;
+    EntityId _localPlayerId;
+
+    // live entities per squad id, and the ids of the squads that died out
+    vector<u32> _squadSizes;
+    vector<SquadId> _freeSquads;
+
+    u64 _tickUs;
+    u64 _tickAcc;
+    u32 _numTicks;
+    bool _ownsCoordinator;
+    SystemScheduler _scheduler;
+
+    // side of the hilbert curve's square, the level size rounded up to a power of 2
+    u32 _hilbertSide;
+    // entities spawned, or moved to another block of tiles, since the last sort
+    u32 _numDrifted;
+    vector<u64> _sortKeys;
+    vector<u32> _sortOrder;
+
+    friend struct SimBench;
+    friend struct SoakBench;
+  };
+}
@@ -0,0 +1,279 @@
+#include "snapshot.hpp"
+
+using namespace pang;
+
+namespace pang
+{
+  SnapshotPublisher g_snapshotPublisher;
+}
+
+namespace
+{
+  const char SNAPSHOT_MAGIC[8] = { 'P', 'A', 'N', 'G', 'S', 'N', 'P', '1' };
+
+  // capacity for spawns after the region is created
+  const u32 MIN_CAPACITY = 1024;
+  const u32 CAPACITY_SCALE = 4;
+
+  //----------------------------------------------------------------------------------
+  string ShmName(const string& name)
+  {
+    // posix shared memory names start with a single slash
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+  }
+
+  //----------------------------------------------------------------------------------
+  SnapshotFrame* FrameAt(const SnapshotHeader* header, u32 idx)
+  {
+    return (SnapshotFrame*)((u8*)header + header->frameOffsets[idx]);
+  }
+
+  //----------------------------------------------------------------------------------
+  SnapshotEntity* EntitiesAt(SnapshotFrame* frame)
+  {
+    return (SnapshotEntity*)(frame + 1);
+  }
+
+  //----------------------------------------------------------------------------------
+  SnapshotBullet* BulletsAt(const SnapshotHeader* header, SnapshotFrame* frame)
+  {
+    return (SnapshotBullet*)(EntitiesAt(frame) + header->maxEntities);
+  }
+}
+
+//----------------------------------------------------------------------------------
+SnapshotPublisher::SnapshotPublisher()
+    : _header(nullptr)
+    , _numTruncated(0)
+{
+}
+
+//----------------------------------------------------------------------------------
+SnapshotPublisher::~SnapshotPublisher()
+{
+  Close();
+}
+
+//----------------------------------------------------------------------------------
+bool SnapshotPublisher::Open(const string& name, const Simulation& sim)
+{
+#ifdef _WIN32
+  printf("snapshot publishing isn't supported on windows\n");
+  return false;
+#else
+  if (IsOpen())
+    return false;
+
+  u32 width, height;
+  sim.GetLevel().GetSize(&width, &height);
+  u32 maxEntities = max(MIN_CAPACITY, CAPACITY_SCALE * sim.Entities().Size());
+  u32 maxBullets = maxEntities;
+
+  u32 levelOffset = sizeof(SnapshotHeader);
+  u32 frameSize = sizeof(SnapshotFrame) + maxEntities * sizeof(SnapshotEntity) + maxBullets * sizeof(SnapshotBullet);
+  // keep the frames cache line aligned, so the two buffers don't share a line
+  u32 frameOffset = (levelOffset + 2 * width * height + 63) & ~63;
+  frameSize = (frameSize + 63) & ~63;
+  u32 size = frameOffset + 2 * frameSize;
+
+  _name = ShmName(name);
+  int fd = shm_open(_name.c_str(), O_CREAT | O_RDWR, 0644);
+  if (fd == -1)
+  {
+    printf("shm_open %s failed: %s\n", _name.c_str(), strerror(errno));
+    return false;
+  }
+
+  // truncating to 0 first zeroes any region left over from an earlier run
+  void* mem = MAP_FAILED;
+  if (ftruncate(fd, 0) == 0 && ftruncate(fd, size) == 0)
+    mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (mem == MAP_FAILED)
+  {
+    printf("unable to map %s: %s\n", _name.c_str(), strerror(errno));
+    shm_unlink(_name.c_str());
+    return false;
+  }
+
+  _header = new (mem) SnapshotHeader();
+  _header->size = size;
+  _header->width = width;
+  _header->height = height;
+  _header->gridSize = sim.GridSize();
+  _header->maxEntities = maxEntities;
+  _header->maxBullets = maxBullets;
+  _header->levelOffset = levelOffset;
+  _header->frameOffsets[0] = frameOffset;
+  _header->frameOffsets[1] = frameOffset + frameSize;
+  new (FrameAt(_header, 0)) SnapshotFrame();
+  new (FrameAt(_header, 1)) SnapshotFrame();
+
+  u8* terrain = (u8*)mem + levelOffset;
+  sim.GetLevel().GetTerrainAndHeat(terrain, terrain + width * height);
+
+  Publish(sim);
+
+  // the magic goes in last, so a viewer never sees a partially initialized region
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(_header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  return true;
+#endif
+}
+
+//----------------------------------------------------------------------------------
+void SnapshotPublisher::Close()
+{
+#ifndef _WIN32
+  if (!IsOpen())
+    return;
+
+  if (_numTruncated)
+    printf("snapshot publisher left out entities or bullets in %u ticks\n", _numTruncated);
+
+  munmap(_header, _header->size);
+  shm_unlink(_name.c_str());
+  _header = nullptr;
+#endif
+}
+
+//----------------------------------------------------------------------------------
+void SnapshotPublisher::Publish(const Simulation& sim)
+{
+  if (!_header)
+    return;
+
+  // write to the buffer that doesn't hold the newest frame
+  u32 idx = _header->latest.load(std::memory_order_relaxed) ^ 1;
+  SnapshotFrame* frame = FrameAt(_header, idx);
+  u32 seq = frame->seq.load(std::memory_order_relaxed);
+  frame->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  const EntityStore& src = sim.Entities();
+  u32 numEntities = min(src.Size(), _header->maxEntities);
+  SnapshotEntity* entities = EntitiesAt(frame);
+  for (u32 i = 0; i < numEntities; ++i)
+  {
+    SnapshotEntity& dst = entities[i];
+    dst.id = src._id[i];
+    dst.squadId = src._squadId[i];
+    dst.x = src._pos[i].x;
+    dst.y = src._pos[i].y;
+    dst.rot = src._rot[i];
+  }
+
+  u32 numBullets = 0;
+  SnapshotBullet* bullets = BulletsAt(_header, frame);
+  for (const Bullet& b : sim.Bullets())
+  {
+    if (numBullets == _header->maxBullets)
+      break;
+
+    SnapshotBullet& dst = bullets[numBullets++];
+    dst.x = b.pos.x;
+    dst.y = b.pos.y;
+  }
+
+  if (numEntities < src.Size() || numBullets < sim.Bullets().size())
+    ++_numTruncated;
+
+  frame->tick = sim.NumTicks();
+  frame->localPlayerId = sim.LocalPlayerId();
+  frame->numEntities = numEntities;
+  frame->numBullets = numBullets;
+
+  frame->seq.store(seq + 2, std::memory_order_release);
+  _header->latest.store(idx, std::memory_order_release);
+}
+
+//----------------------------------------------------------------------------------
+SnapshotReader::SnapshotReader()
+    : _header(nullptr)
+    , _size(0)
+{
+}
+
+//----------------------------------------------------------------------------------
+SnapshotReader::~SnapshotReader()
+{
+  Close();
+}
+
+//----------------------------------------------------------------------------------
+bool SnapshotReader::Open(const string& name)
+{
+#ifdef _WIN32
+  return false;
+#else
+  if (_header)
+    return false;
+
+  int fd = shm_open(ShmName(name).c_str(), O_RDONLY, 0);
+  if (fd == -1)
+    return false;
+
+  struct stat st;
+  void* mem = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(SnapshotHeader))
+    mem = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (mem == MAP_FAILED)
+    return false;
+
+  const SnapshotHeader* header = (const SnapshotHeader*)mem;
+  bool valid = memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (!valid || header->size != st.st_size)
+  {
+    munmap(mem, st.st_size);
+    return false;
+  }
+
+  _header = header;
+  _size = (u32)st.st_size;
+  return true;
+#endif
+}
+
+//----------------------------------------------------------------------------------
+void SnapshotReader::Close()
+{
+#ifndef _WIN32
+  if (!_header)
+    return;
+
+  munmap((void*)_header, _size);
+  _header = nullptr;
+#endif
+}
+
+//----------------------------------------------------------------------------------
+const SnapshotFrame* SnapshotReader::Acquire(u32* seq) const
+{
+  u32 idx = _header->latest.load(std::memory_order_acquire);
+  const SnapshotFrame* frame = FrameAt(_header, idx);
+  *seq = frame->seq.load(std::memory_order_acquire);
+  return *seq & 1 ? nullptr : frame;
+}
+
+//----------------------------------------------------------------------------------
+bool SnapshotReader::Validate(const SnapshotFrame* frame, u32 seq) const
+{
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return frame->seq.load(std::memory_order_relaxed) == seq;
+}
+
+//----------------------------------------------------------------------------------
+const SnapshotEntity* SnapshotReader::Entities(const SnapshotFrame* frame) const
+{
+  return EntitiesAt((SnapshotFrame*)frame);
+}
+
+//----------------------------------------------------------------------------------
+const SnapshotBullet* SnapshotReader::Bullets(const SnapshotFrame* frame) const
+{
+  return BulletsAt(_header, (SnapshotFrame*)frame);
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "types.hpp"
+#include "simulation.hpp"
+
+namespace pang
+{
+  // Layout of the shared memory region. The header is followed by the level (the terrain,
+  // then the heat, width * height bytes each, row major) and two frame buffers, each a
+  // SnapshotFrame followed by maxEntities entities and maxBullets bullets.
+  // The level is written once, when the region is created. Frames alternate between the
+  // buffers, each guarded by its own seqlock, so the newest frame stays untouched for a
+  // whole tick while a viewer renders straight from it
+  struct SnapshotEntity
+  {
+    EntityId id;
+    SquadId squadId;
+    u16 pad;
+    float x, y;
+    float rot;
+  };
+
+  struct SnapshotBullet
+  {
+    float x, y;
+  };
+
+  struct SnapshotFrame
+  {
+    // odd while the frame is being written
+    atomic<u32> seq;
+    u32 tick;
+    EntityId localPlayerId;
+    u32 numEntities;
+    u32 numBullets;
+    u32 pad;
+  };
+
+  struct SnapshotHeader
+  {
+    char magic[8];
+    u32 size;
+    u32 width, height;
+    u32 gridSize;
+    u32 maxEntities, maxBullets;
+    u32 levelOffset;
+    u32 frameOffsets[2];
+    // the buffer holding the newest complete frame
+    atomic<u32> latest;
+  };
+
+  // Publishes the simulation into a POSIX shared memory region, for out of process
+  // viewers. Entities and bullets past the capacity chosen at Open are left out.
+  // Not available on windows
+  class SnapshotPublisher
+  {
+  public:
+    SnapshotPublisher();
+    ~SnapshotPublisher();
+
+    // creates the region, and publishes the level
+    bool Open(const string& name, const Simulation& sim);
+    // unmaps and unlinks the region
+    void Close();
+    bool IsOpen() const { return _header != nullptr; }
+
+    void Publish(const Simulation& sim);
+
+  private:
+    string _name;
+    SnapshotHeader* _header;
+    u32 _numTruncated;
+  };
+
+  // Maps a region created by SnapshotPublisher, read only
+  class SnapshotReader
+  {
+  public:
+    SnapshotReader();
+    ~SnapshotReader();
+
+    bool Open(const string& name);
+    void Close();
+
+    const SnapshotHeader& Header() const { return *_header; }
+    const u8* Terrain() const { return (const u8*)_header + _header->levelOffset; }
+    const u8* Heat() const { return Terrain() + _header->width * _header->height; }
+
+    // returns the newest frame, and the sequence number to validate it with, or nullptr
+    // if the publisher is writing it
+    const SnapshotFrame* Acquire(u32* seq) const;
+    // true if the frame wasn't touched by the publisher since it was acquired
+    bool Validate(const SnapshotFrame* frame, u32 seq) const;
+
+    const SnapshotEntity* Entities(const SnapshotFrame* frame) const;
+    const SnapshotBullet* Bullets(const SnapshotFrame* frame) const;
+
+  private:
+    const SnapshotHeader* _header;
+    u32 _size;
+  };
+
+  extern SnapshotPublisher g_snapshotPublisher;
+}
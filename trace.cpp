@@ -0,0 +1,96 @@
+#include "trace.hpp"
+
+using namespace pang;
+
+namespace pang
+{
+  TraceRecorder g_traceRecorder;
+}
+
+//----------------------------------------------------------------------------------
+TraceRecorder::TraceRecorder()
+    : _startNs(0)
+    , _frameStartNs(0)
+    , _framesLeft(0)
+    , _numDropped(0)
+    , _recording(false)
+{
+}
+
+//----------------------------------------------------------------------------------
+void TraceRecorder::Start(const string& filename, u32 numFrames)
+{
+  if (_recording || numFrames == 0)
+    return;
+
+  _filename = filename;
+  _framesLeft = numFrames;
+  _numDropped = 0;
+  _events.clear();
+  _events.reserve(MAX_EVENTS);
+  _startNs = _frameStartNs = NowNs();
+  _recording = true;
+}
+
+//----------------------------------------------------------------------------------
+void TraceRecorder::AddEvent(const char* name, u64 startNs, u64 durationNs)
+{
+  // skip scopes that were already open when the recording started
+  if (startNs < _startNs)
+    return;
+
+  // the buffer is never grown while recording
+  if (_events.size() == _events.capacity())
+  {
+    ++_numDropped;
+    return;
+  }
+
+  Event e = { name, startNs, durationNs };
+  _events.push_back(e);
+}
+
+//----------------------------------------------------------------------------------
+void TraceRecorder::EndFrame()
+{
+  if (!_recording)
+    return;
+
+  u64 now = NowNs();
+  AddEvent("Frame", _frameStartNs, now - _frameStartNs);
+  _frameStartNs = now;
+
+  if (--_framesLeft == 0)
+  {
+    _recording = false;
+    Write();
+  }
+}
+
+//----------------------------------------------------------------------------------
+bool TraceRecorder::Write()
+{
+  FILE* f = fopen(_filename.c_str(), "w");
+  if (!f)
+    return false;
+
+  fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"pang\"}}");
+  for (const Event& e : _events)
+  {
+    // timestamps are in microseconds, relative to the start of the recording
+    fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"pang\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+        e.name, (e.startNs - _startNs) / 1e3, e.durationNs / 1e3);
+  }
+  fprintf(f, "\n]}\n");
+  fclose(f);
+
+  printf("wrote %u trace events to %s", (u32)_events.size(), _filename.c_str());
+  if (_numDropped)
+    printf(" (%u dropped)", _numDropped);
+  printf("\n");
+
+  _events.clear();
+  _events.shrink_to_fit();
+  return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "types.hpp"
+
+namespace pang
+{
+  // Records scoped events for a bounded number of frames, and writes them as chrome
+  // trace-event json (loadable in chrome://tracing or perfetto). When not recording, a
+  // scope costs a single branch, so the recorder is always compiled in.
+  struct TraceRecorder
+  {
+    enum { MAX_EVENTS = 1 << 20 };
+
+    TraceRecorder();
+
+    // starts recording the next numFrames frames, after which the trace is written to filename
+    void Start(const string& filename, u32 numFrames);
+    bool IsRecording() const { return _recording; }
+
+    // note, name must outlive the recording (typically a string literal)
+    void AddEvent(const char* name, u64 startNs, u64 durationNs);
+    void EndFrame();
+
+  private:
+    bool Write();
+
+    struct Event
+    {
+      const char* name;
+      u64 startNs;
+      u64 durationNs;
+    };
+
+    vector<Event> _events;
+    string _filename;
+    u64 _startNs;
+    u64 _frameStartNs;
+    u32 _framesLeft;
+    u32 _numDropped;
+    bool _recording;
+  };
+
+  extern TraceRecorder g_traceRecorder;
+
+  struct ScopedTrace
+  {
+    ScopedTrace(const char* name) : _name(name), _start(g_traceRecorder.IsRecording() ? NowNs() : 0) {}
+    ~ScopedTrace()
+    {
+      if (_start && g_traceRecorder.IsRecording())
+        g_traceRecorder.AddEvent(_name, _start, NowNs() - _start);
+    }
+    const char* _name;
+    u64 _start;
+  };
+
+#define PROFILE_CONCAT_INNER(a, b) a ## b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#define TRACE_SCOPE(name) pang::ScopedTrace PROFILE_CONCAT(scopedTrace, __LINE__)(name)
+}
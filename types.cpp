@@ -2,8 +2,20 @@
 
 using namespace pang;
 
+namespace pang
+{
+  const float PI = 3.1415926f;
+}
+
 //----------------------------------------------------------------------------------
 bool pang::operator==(const Tile& lhs, const Tile& rhs)
 {
   return lhs.x == rhs.x && lhs.y == rhs.y;
 }
+
+//----------------------------------------------------------------------------------
+u64 pang::NowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -3,8 +3,20 @@
 namespace pang
 {
 
-  typedef u16 EntityId;
+  // An entity handle: the index of the entity's entry in the store's handle table in the
+  // low bits, and the generation of the entry when the entity was added in the high bits.
+  // Generations start at 1, so no entity has id 0
+  typedef u32 EntityId;
+  const u32 ENTITY_INDEX_BITS = 22;
+  const u32 ENTITY_GENERATION_BITS = 32 - ENTITY_INDEX_BITS;
+  const EntityId NO_ENTITY = 0;
+
+  inline u32 EntityIndex(EntityId id) { return id & ((1 << ENTITY_INDEX_BITS) - 1); }
+  inline u32 EntityGeneration(EntityId id) { return id >> ENTITY_INDEX_BITS; }
+
   typedef u16 SquadId;
+  // the local player doesn't belong to a squad
+  const SquadId NO_SQUAD = 0xffff;
 
   struct Tile
   {
@@ -16,4 +28,35 @@ namespace pang
   };
 
   bool operator==(const Tile& lhs, const Tile& rhs);
+
+  // monotonic timestamp, used for profiling
+  u64 NowNs();
+
+  //----------------------------------------------------------------------------------
+  inline u64 HashMix(u64 h)
+  {
+    // murmur3 finalizer
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+  }
+
+  //----------------------------------------------------------------------------------
+  inline u64 HashCombine(u64 h, u64 v)
+  {
+    return HashMix(h ^ (v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2)));
+  }
+
+  //----------------------------------------------------------------------------------
+  inline u64 HashFloats(u64 h, float a, float b)
+  {
+    // the exact bits, so even a -0 for 0 shows up
+    u32 bits[2];
+    memcpy(&bits[0], &a, sizeof(float));
+    memcpy(&bits[1], &b, sizeof(float));
+    return HashCombine(h, ((u64)bits[0] << 32) | bits[1]);
+  }
 }
@@ -0,0 +1,48 @@
+#include "visibility.hpp"
+
+using namespace pang;
+
+//----------------------------------------------------------------------------------
+VisibilityResults::VisibilityResults()
+    : _curRow(0)
+{
+}
+
+//----------------------------------------------------------------------------------
+void VisibilityResults::Begin(u32 numHandles, u32 maxTargets)
+{
+  Row empty = { NO_ENTITY, 0, 0 };
+  _rows.assign(numHandles, empty);
+  _order.clear();
+  _targets.clear();
+  _targets.reserve(maxTargets);
+}
+
+//----------------------------------------------------------------------------------
+void VisibilityResults::AddViewer(EntityId viewer)
+{
+  _curRow = EntityIndex(viewer);
+  assert(_curRow < _rows.size());
+
+  Row& row = _rows[_curRow];
+  row.viewer = viewer;
+  row.offset = (u32)_targets.size();
+  row.count = 0;
+  _order.push_back(_curRow);
+}
+
+//----------------------------------------------------------------------------------
+VisibilityResults::Range VisibilityResults::Visible(EntityId viewer) const
+{
+  u32 index = EntityIndex(viewer);
+  if (index >= _rows.size() || _rows[index].viewer != viewer || _targets.empty())
+  {
+    Range res = { nullptr, nullptr };
+    return res;
+  }
+
+  const Row& row = _rows[index];
+  const EntityId* first = _targets.data() + row.offset;
+  Range res = { first, first + row.count };
+  return res;
+}
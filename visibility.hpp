@@ -0,0 +1,65 @@
+#pragma once
+#include "types.hpp"
+
+namespace pang
+{
+  // The entities each viewer saw in the last perception update, in compressed sparse row
+  // form: one row per viewer holding an (offset, count) range into a single array of
+  // targets. The results are rebuilt in one pass over the viewers, and both arrays are
+  // reused between updates.
+  // Rows are indexed by the viewer's handle index and hold its id, so they stay valid
+  // when the entity store is compacted or re-sorted, and an entity that wasn't a viewer
+  // in the last update (or took over a freed index) sees nothing
+  class VisibilityResults
+  {
+  public:
+    struct Range
+    {
+      const EntityId* begin() const { return first; }
+      const EntityId* end() const { return last; }
+      u32 size() const { return (u32)(last - first); }
+      bool empty() const { return first == last; }
+      const EntityId* first;
+      const EntityId* last;
+    };
+
+    VisibilityResults();
+
+    // starts new results, for viewers with handle indices below numHandles. room is
+    // reserved for maxTargets targets, so an update within it doesn't allocate
+    void Begin(u32 numHandles, u32 maxTargets);
+    // starts the viewer's row. the targets added until the next viewer go in it
+    void AddViewer(EntityId viewer);
+    void AddTarget(EntityId target) { _targets.push_back(target); ++_rows[_curRow].count; }
+
+    Range Visible(EntityId viewer) const;
+    u32 NumVisible(EntityId viewer) const { return Visible(viewer).size(); }
+    u32 NumTargets() const { return (u32)_targets.size(); }
+
+    // calls fn(viewer, target) for every target seen, in the order they were added
+    template <typename Fn>
+    void ForEach(const Fn& fn) const
+    {
+      for (u32 row : _order)
+      {
+        const Row& r = _rows[row];
+        for (u32 i = r.offset; i < r.offset + r.count; ++i)
+          fn(r.viewer, _targets[i]);
+      }
+    }
+
+  private:
+    struct Row
+    {
+      EntityId viewer;
+      u32 offset;
+      u32 count;
+    };
+
+    vector<Row> _rows;
+    // the rows in the order the viewers were added
+    vector<u32> _order;
+    vector<EntityId> _targets;
+    u32 _curRow;
+  };
+}